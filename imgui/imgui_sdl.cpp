@@ -62,51 +62,68 @@ namespace
 		};
 	}
 
-	template <typename Key, typename Value, std::size_t Size> class LRUCache
+	template <typename Key, typename Value, std::size_t Size, std::size_t MaxBytes> class LRUCache
 	{
 	public:
-		bool Contains(const Key& key) const
+		// Returns the cached value or null, counting the lookup as a hit or a miss.
+		const Value* Find(const Key& key)
 		{
-			return Container.find(key) != Container.end();
-		}
-
-		const Value& At(const Key& key)
-		{
-			assert(Contains(key));
-
 			const auto location = Container.find(key);
+			if (location == Container.end())
+			{
+				Misses++;
+				return nullptr;
+			}
+
+			Hits++;
 			Order.splice(Order.begin(), Order, location->second);
-			return location->second->second;
+			return &location->second->second.Item;
 		}
 
-		void Insert(const Key& key, Value value)
+		void Insert(const Key& key, Value value, std::size_t bytes)
 		{
 			const auto existingLocation = Container.find(key);
 			if (existingLocation != Container.end())
 			{
+				Bytes -= existingLocation->second->second.Bytes;
 				Order.erase(existingLocation->second);
 				Container.erase(existingLocation);
 			}
 
-			Order.push_front(std::make_pair(key, std::move(value)));
+			Order.push_front(std::make_pair(key, Entry{ std::move(value), bytes }));
 			Container.insert(std::make_pair(key, Order.begin()));
+			Bytes += bytes;
 
 			Clean();
 		}
+
+		std::size_t Count() const { return Container.size(); }
+
+		std::size_t Hits = 0, Misses = 0, Evictions = 0;
+		std::size_t Bytes = 0;
 	private:
+		struct Entry
+		{
+			Value Item;
+			std::size_t Bytes;
+		};
+
+		// Evicts the least recently used entries until both the entry count and the memory held by the entries are within bounds.
 		void Clean()
 		{
-			while (Container.size() > Size)
+			while (Container.size() > Size || (Bytes > MaxBytes && Container.size() > 1))
 			{
 				auto last = Order.end();
 				last--;
+				Bytes -= last->second.Bytes;
 				Container.erase(last->first);
 				Order.pop_back();
+				Evictions++;
 			}
 		}
 
-		std::list<std::pair<Key, Value>> Order;
-		std::unordered_map<Key, decltype(Order.begin()), TupleHash::Hash<Key>> Container;
+		std::list<std::pair<Key, Entry>> Order;
+		std::unordered_map<Key, typename std::list<std::pair<Key, Entry>>::iterator, TupleHash::Hash<Key>> Container;
 	};
 
 	struct Color
@@ -159,6 +176,9 @@ namespace
 		// You can tweak these to values that you find that work the best.
 		static constexpr std::size_t UniformColorTriangleCacheSize = 512;
 		static constexpr std::size_t GenericTriangleCacheSize = 64;
+		// Every cached triangle owns a texture as large as its bounding box, so the caches are also bounded by texture memory.
+		static constexpr std::size_t UniformColorTriangleCacheBytes = 16 * 1024 * 1024;
+		static constexpr std::size_t GenericTriangleCacheBytes = 8 * 1024 * 1024;
 
 		// Uniform color is identified by its color and the coordinates of the edges.
 		using UniformColorTriangleKey = std::tuple<uint32_t, int, int, int, int, int, int>;
@@ -167,8 +187,14 @@ namespace
 		using GenericTriangleVertexKey = std::tuple<int, int, double, double, uint32_t>;
 		using GenericTriangleKey = std::tuple<GenericTriangleVertexKey, GenericTriangleVertexKey, GenericTriangleVertexKey>;
 
-		LRUCache<UniformColorTriangleKey, std::unique_ptr<TriangleCacheItem>, UniformColorTriangleCacheSize> UniformColorTriangleCache;
-		LRUCache<GenericTriangleKey, std::unique_ptr<TriangleCacheItem>, GenericTriangleCacheSize> GenericTriangleCache;
+		LRUCache<UniformColorTriangleKey, std::unique_ptr<TriangleCacheItem>, UniformColorTriangleCacheSize, UniformColorTriangleCacheBytes> UniformColorTriangleCache;
+		LRUCache<GenericTriangleKey, std::unique_ptr<TriangleCacheItem>, GenericTriangleCacheSize, GenericTriangleCacheBytes> GenericTriangleCache;
+
+		// Whether draw lists are submitted with SDL_RenderGeometry. This is turned off if the renderer turns out not to support it.
+		bool UseGeometry = true;
+		bool GeometrySupported = true;
+
+		ImGuiSDL::RenderStats Stats;
 
 		Device(SDL_Renderer* renderer) : Renderer(renderer) { }
 
@@ -404,10 +430,9 @@ namespace
 			std::make_tuple(static_cast<int>(std::round(v2.pos.x)) - renderInfo.MinX, static_cast<int>(std::round(v2.pos.y)) - renderInfo.MinY, v2.uv.x, v2.uv.y, v2.col),
 			std::make_tuple(static_cast<int>(std::round(v3.pos.x)) - renderInfo.MinX, static_cast<int>(std::round(v3.pos.y)) - renderInfo.MinY, v3.uv.x, v3.uv.y, v3.col));
 
-		if (CurrentDevice->GenericTriangleCache.Contains(key))
+		if (const auto* cached = CurrentDevice->GenericTriangleCache.Find(key))
 		{
-			const auto& cached = CurrentDevice->GenericTriangleCache.At(key);
-			DrawCachedTriangle(*cached, renderInfo);
+			DrawCachedTriangle(**cached, renderInfo);
 
 			return;
 		}
@@ -432,7 +457,8 @@ namespace
 		const SDL_Rect destination = { renderInfo.MinX, renderInfo.MinY, cached->Width, cached->Height };
 		SDL_RenderCopy(CurrentDevice->Renderer, cached->Texture, nullptr, &destination);
 
-		CurrentDevice->GenericTriangleCache.Insert(key, std::move(cached));
+		const std::size_t bytes = static_cast<std::size_t>(cached->Width) * cached->Height * 4;
+		CurrentDevice->GenericTriangleCache.Insert(key, std::move(cached), bytes);
 	}
 
 	void DrawUniformColorTriangle(const ImDrawVert& v1, const ImDrawVert& v2, const ImDrawVert& v3)
@@ -446,10 +472,9 @@ namespace
 			static_cast<int>(std::round(v1.pos.x)) - renderInfo.MinX, static_cast<int>(std::round(v1.pos.y)) - renderInfo.MinY,
 			static_cast<int>(std::round(v2.pos.x)) - renderInfo.MinX, static_cast<int>(std::round(v2.pos.y)) - renderInfo.MinY,
 			static_cast<int>(std::round(v3.pos.x)) - renderInfo.MinX, static_cast<int>(std::round(v3.pos.y)) - renderInfo.MinY);
-		if (CurrentDevice->UniformColorTriangleCache.Contains(key))
+		if (const auto* cached = CurrentDevice->UniformColorTriangleCache.Find(key))
 		{
-			const auto& cached = CurrentDevice->UniformColorTriangleCache.At(key);
-			DrawCachedTriangle(*cached, renderInfo);
+			DrawCachedTriangle(**cached, renderInfo);
 
 			return;
 		}
@@ -462,7 +487,8 @@ namespace
 		const SDL_Rect destination = { renderInfo.MinX, renderInfo.MinY, cached->Width, cached->Height };
 		SDL_RenderCopy(CurrentDevice->Renderer, cached->Texture, nullptr, &destination);
 
-		CurrentDevice->UniformColorTriangleCache.Insert(key, std::move(cached));
+		const std::size_t bytes = static_cast<std::size_t>(cached->Width) * cached->Height * 4;
+		CurrentDevice->UniformColorTriangleCache.Insert(key, std::move(cached), bytes);
 	}
 
 	void DrawRectangle(const Rect& bounding, SDL_Texture* texture, int textureWidth, int textureHeight, const Color& color, bool doHorizontalFlip, bool doVerticalFlip)
@@ -511,6 +537,112 @@ namespace
 		SDL_QueryTexture(texture, nullptr, nullptr, &width, &height);
 		DrawRectangle(bounding, texture, width, height, color, doHorizontalFlip, doVerticalFlip);
 	}
+
+	// Draws a command triangle by triangle, detecting rectangles and caching rasterized triangles in textures. This works with any
+	// renderer, but is slow for anything but a few simple windows.
+	void DrawCommandTriangles(const ImVector<ImDrawVert>& vertexBuffer, const ImDrawIdx* indexBuffer, const ImDrawCmd* drawCommand, bool isWrappedTexture)
+	{
+		// Loops over triangles.
+		for (unsigned int i = 0; i + 3 <= drawCommand->ElemCount; i += 3)
+		{
+			const ImDrawVert& v0 = vertexBuffer[indexBuffer[i + 0]];
+			const ImDrawVert& v1 = vertexBuffer[indexBuffer[i + 1]];
+			const ImDrawVert& v2 = vertexBuffer[indexBuffer[i + 2]];
+
+			const Rect& bounding = Rect::CalculateBoundingBox(v0, v1, v2);
+
+			const bool isTriangleUniformColor = v0.col == v1.col && v1.col == v2.col;
+			const bool doesTriangleUseOnlyColor = bounding.UsesOnlyColor();
+
+			// Actually, since we render a whole bunch of rectangles, we try to first detect those, and render them more efficiently.
+			// How are rectangles detected? It's actually pretty simple: If all 6 vertices lie on the extremes of the bounding box,
+			// it's a rectangle.
+			if (i + 6 <= drawCommand->ElemCount)
+			{
+				const ImDrawVert& v3 = vertexBuffer[indexBuffer[i + 3]];
+				const ImDrawVert& v4 = vertexBuffer[indexBuffer[i + 4]];
+				const ImDrawVert& v5 = vertexBuffer[indexBuffer[i + 5]];
+
+				const bool isUniformColor = isTriangleUniformColor && v2.col == v3.col && v3.col == v4.col && v4.col == v5.col;
+
+				if (isUniformColor
+				&& bounding.IsOnExtreme(v0.pos)
+				&& bounding.IsOnExtreme(v1.pos)
+				&& bounding.IsOnExtreme(v2.pos)
+				&& bounding.IsOnExtreme(v3.pos)
+				&& bounding.IsOnExtreme(v4.pos)
+				&& bounding.IsOnExtreme(v5.pos))
+				{
+					// ImGui gives the triangles in a nice order: the first vertex happens to be the topleft corner of our rectangle.
+					// We need to check for the orientation of the texture, as I believe in theory ImGui could feed us a flipped texture,
+					// so that the larger texture coordinates are at topleft instead of bottomright.
+					// We don't consider equal texture coordinates to require a flip, as then the rectangle is mostlikely simply a colored rectangle.
+					const bool doHorizontalFlip = v2.uv.x < v0.uv.x;
+					const bool doVerticalFlip = v2.uv.x < v0.uv.x;
+
+					if (isWrappedTexture)
+					{
+						DrawRectangle(bounding, static_cast<const Texture*>(drawCommand->TextureId), Color(v0.col), doHorizontalFlip, doVerticalFlip);
+					}
+					else
+					{
+						DrawRectangle(bounding, static_cast<SDL_Texture*>(drawCommand->TextureId), Color(v0.col), doHorizontalFlip, doVerticalFlip);
+					}
+
+					CurrentDevice->Stats.FallbackRectangles++;
+					i += 3;  // Additional increment to account for the extra 3 vertices we consumed.
+					continue;
+				}
+			}
+
+			if (isTriangleUniformColor && doesTriangleUseOnlyColor)
+			{
+				DrawUniformColorTriangle(v0, v1, v2);
+				CurrentDevice->Stats.FallbackTriangles++;
+			}
+			else
+			{
+				// Currently we assume that any non rectangular texture samples the font texture. Dunno if that's what actually happens, but it seems to work.
+				assert(isWrappedTexture);
+				DrawTriangle(v0, v1, v2, static_cast<const Texture*>(drawCommand->TextureId));
+				CurrentDevice->Stats.FallbackTriangles++;
+			}
+		}
+	}
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	// Submits all triangles of a command in one call. The vertex buffer of the draw list is passed as is: ImGui's packed colors
+	// have the same byte order as SDL_Color on little endian machines. Returns false if the renderer can't draw geometry.
+	bool DrawCommandGeometry(const ImVector<ImDrawVert>& vertexBuffer, const ImDrawIdx* indexBuffer, const ImDrawCmd* drawCommand, bool isWrappedTexture)
+	{
+		SDL_Texture* texture = isWrappedTexture
+			? static_cast<const Texture*>(drawCommand->TextureId)->Source
+			: static_cast<SDL_Texture*>(drawCommand->TextureId);
+
+		// The rectangle fallback tints textures with a color mod, while geometry carries its colors in the vertices.
+		if (texture) SDL_SetTextureColorMod(texture, 255, 255, 255);
+
+		const ImDrawVert* vertices = vertexBuffer.Data;
+		const int stride = static_cast<int>(sizeof(ImDrawVert));
+
+		// SDL 2.0.18 took the colors as ints, 2.0.20 changed them to SDL_Color with the same layout.
+#if SDL_VERSION_ATLEAST(2, 0, 20)
+		using GeometryColor = SDL_Color;
+#else
+		using GeometryColor = int;
+#endif
+
+		const int result = SDL_RenderGeometryRaw(CurrentDevice->Renderer, texture,
+			reinterpret_cast<const float*>(reinterpret_cast<const char*>(vertices) + IM_OFFSETOF(ImDrawVert, pos)), stride,
+			reinterpret_cast<const GeometryColor*>(reinterpret_cast<const char*>(vertices) + IM_OFFSETOF(ImDrawVert, col)), stride,
+			reinterpret_cast<const float*>(reinterpret_cast<const char*>(vertices) + IM_OFFSETOF(ImDrawVert, uv)), stride,
+			vertexBuffer.Size, indexBuffer, static_cast<int>(drawCommand->ElemCount), static_cast<int>(sizeof(ImDrawIdx)));
+		if (result != 0) return false;
+
+		CurrentDevice->Stats.GeometryCalls++;
+		return true;
+	}
+#endif
 }
 
 namespace ImGuiSDL
@@ -550,6 +682,16 @@ namespace ImGuiSDL
 		delete CurrentDevice;
 	}
 
+	void SetBatchedRendering(bool enabled)
+	{
+		CurrentDevice->UseGeometry = enabled;
+	}
+
+	const RenderStats& GetRenderStats()
+	{
+		return CurrentDevice->Stats;
+	}
+
 	void Render(ImDrawData* drawData)
 	{
 		SDL_BlendMode blendMode;
@@ -567,15 +709,24 @@ namespace ImGuiSDL
 
 		ImGuiIO& io = ImGui::GetIO();
 
+		RenderStats& stats = CurrentDevice->Stats;
+		stats.DrawLists = drawData->CmdListsCount;
+		stats.DrawCommands = 0;
+		stats.GeometryCalls = 0;
+		stats.FallbackTriangles = 0;
+		stats.FallbackRectangles = 0;
+
 		for (int n = 0; n < drawData->CmdListsCount; n++)
 		{
 			auto commandList = drawData->CmdLists[n];
-			auto vertexBuffer = commandList->VtxBuffer;
+			// A reference: copying the vertex buffer of every draw list each frame is not free.
+			const auto& vertexBuffer = commandList->VtxBuffer;
 			auto indexBuffer = commandList->IdxBuffer.Data;
 
 			for (int cmd_i = 0; cmd_i < commandList->CmdBuffer.Size; cmd_i++)
 			{
 				const ImDrawCmd* drawCommand = &commandList->CmdBuffer[cmd_i];
+				stats.DrawCommands++;
 
 				const Device::ClipRect clipRect = {
 					static_cast<int>(drawCommand->ClipRect.x),
@@ -593,68 +744,15 @@ namespace ImGuiSDL
 				{
 					const bool isWrappedTexture = drawCommand->TextureId == io.Fonts->TexID;
 
-					// Loops over triangles.
-					for (unsigned int i = 0; i + 3 <= drawCommand->ElemCount; i += 3)
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+					if (CurrentDevice->UseGeometry && CurrentDevice->GeometrySupported && clipRect.Width > 0 && clipRect.Height > 0)
 					{
-						const ImDrawVert& v0 = vertexBuffer[indexBuffer[i + 0]];
-						const ImDrawVert& v1 = vertexBuffer[indexBuffer[i + 1]];
-						const ImDrawVert& v2 = vertexBuffer[indexBuffer[i + 2]];
-
-						const Rect& bounding = Rect::CalculateBoundingBox(v0, v1, v2);
-
-						const bool isTriangleUniformColor = v0.col == v1.col && v1.col == v2.col;
-						const bool doesTriangleUseOnlyColor = bounding.UsesOnlyColor();
-
-						// Actually, since we render a whole bunch of rectangles, we try to first detect those, and render them more efficiently.
-						// How are rectangles detected? It's actually pretty simple: If all 6 vertices lie on the extremes of the bounding box,
-						// it's a rectangle.
-						if (i + 6 <= drawCommand->ElemCount)
-						{
-							const ImDrawVert& v3 = vertexBuffer[indexBuffer[i + 3]];
-							const ImDrawVert& v4 = vertexBuffer[indexBuffer[i + 4]];
-							const ImDrawVert& v5 = vertexBuffer[indexBuffer[i + 5]];
-
-							const bool isUniformColor = isTriangleUniformColor && v2.col == v3.col && v3.col == v4.col && v4.col == v5.col;
-
-							if (isUniformColor
-							&& bounding.IsOnExtreme(v0.pos)
-							&& bounding.IsOnExtreme(v1.pos)
-							&& bounding.IsOnExtreme(v2.pos)
-							&& bounding.IsOnExtreme(v3.pos)
-							&& bounding.IsOnExtreme(v4.pos)
-							&& bounding.IsOnExtreme(v5.pos))
-							{
-								// ImGui gives the triangles in a nice order: the first vertex happens to be the topleft corner of our rectangle.
-								// We need to check for the orientation of the texture, as I believe in theory ImGui could feed us a flipped texture,
-								// so that the larger texture coordinates are at topleft instead of bottomright.
-								// We don't consider equal texture coordinates to require a flip, as then the rectangle is mostlikely simply a colored rectangle.
-								const bool doHorizontalFlip = v2.uv.x < v0.uv.x;
-								const bool doVerticalFlip = v2.uv.x < v0.uv.x;
-
-								if (isWrappedTexture)
-								{
-									DrawRectangle(bounding, static_cast<const Texture*>(drawCommand->TextureId), Color(v0.col), doHorizontalFlip, doVerticalFlip);
-								}
-								else
-								{
-									DrawRectangle(bounding, static_cast<SDL_Texture*>(drawCommand->TextureId), Color(v0.col), doHorizontalFlip, doVerticalFlip);
-								}
-
-								i += 3;  // Additional increment to account for the extra 3 vertices we consumed.
-								continue;
-							}
-						}
-
-						if (isTriangleUniformColor && doesTriangleUseOnlyColor)
-						{
-							DrawUniformColorTriangle(v0, v1, v2);
-						}
-						else
-						{
-							// Currently we assume that any non rectangular texture samples the font texture. Dunno if that's what actually happens, but it seems to work.
-							assert(isWrappedTexture);
-							DrawTriangle(v0, v1, v2, static_cast<const Texture*>(drawCommand->TextureId));
-						}
+						CurrentDevice->GeometrySupported = DrawCommandGeometry(vertexBuffer, indexBuffer, drawCommand, isWrappedTexture);
+					}
+					if (!CurrentDevice->UseGeometry || !CurrentDevice->GeometrySupported)
+#endif
+					{
+						DrawCommandTriangles(vertexBuffer, indexBuffer, drawCommand, isWrappedTexture);
 					}
 				}
 
@@ -662,6 +760,13 @@ namespace ImGuiSDL
 			}
 		}
 
+		stats.Batched = CurrentDevice->UseGeometry && CurrentDevice->GeometrySupported;
+		stats.CachedTriangles = CurrentDevice->UniformColorTriangleCache.Count() + CurrentDevice->GenericTriangleCache.Count();
+		stats.CachedTextureBytes = CurrentDevice->UniformColorTriangleCache.Bytes + CurrentDevice->GenericTriangleCache.Bytes;
+		stats.CacheHits = CurrentDevice->UniformColorTriangleCache.Hits + CurrentDevice->GenericTriangleCache.Hits;
+		stats.CacheMisses = CurrentDevice->UniformColorTriangleCache.Misses + CurrentDevice->GenericTriangleCache.Misses;
+		stats.CacheEvictions = CurrentDevice->UniformColorTriangleCache.Evictions + CurrentDevice->GenericTriangleCache.Evictions;
+
 		CurrentDevice->DisableClip();
 
 		SDL_SetRenderTarget(CurrentDevice->Renderer, initialRenderTarget);
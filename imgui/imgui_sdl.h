@@ -1,10 +1,33 @@
 ﻿#pragma once
 
+#include <cstddef>
+
 struct ImDrawData;
 struct SDL_Renderer;
 
 namespace ImGuiSDL
 {
+	struct RenderStats
+	{
+		// Counts for the last rendered frame.
+		int DrawLists = 0;
+		int DrawCommands = 0;
+		// Batched SDL_RenderGeometry submissions, one per draw command.
+		int GeometryCalls = 0;
+		// Primitives drawn by the fallback renderer.
+		int FallbackTriangles = 0;
+		int FallbackRectangles = 0;
+		// Whether the last frame was drawn with SDL_RenderGeometry.
+		bool Batched = false;
+
+		// Triangle cache of the fallback renderer. Lookups and evictions are counted since initialization.
+		std::size_t CachedTriangles = 0;
+		std::size_t CachedTextureBytes = 0;
+		std::size_t CacheHits = 0;
+		std::size_t CacheMisses = 0;
+		std::size_t CacheEvictions = 0;
+	};
+
 	// Call this to initialize the SDL renderer device that is internally used by the renderer.
 	void Initialize(SDL_Renderer* renderer, int windowWidth, int windowHeight);
 	// Call this before destroying your SDL renderer or ImGui to ensure that proper cleanup is done. This doesn't do anything critically important though,
@@ -14,4 +37,9 @@ namespace ImGuiSDL
 	// Call this every frame after ImGui::Render with ImGui::GetDrawData(). This will use the SDL_Renderer provided to the interfrace with Initialize
 	// to draw the contents of the draw data to the screen.
 	void Render(ImDrawData* drawData);
+
+	// Draw lists are submitted in batches with SDL_RenderGeometry when built against SDL 2.0.18 or newer and the renderer supports it.
+	// Otherwise (or when disabled here) every triangle is rasterized in software and cached in a texture, which is much slower.
+	void SetBatchedRendering(bool enabled);
+	const RenderStats& GetRenderStats();
 }
@@ -0,0 +1,185 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "./allocation_check.h"
+#include "./allocation_tracker.h"
+#include "./common.h"
+#include "./cycle_detector.h"
+#include "./parallel_rewrite.h"
+#include "./soup.h"
+#include "./automata/automata.h"
+
+// A way of computing generations that must not allocate anything beyond
+// what the rule set's rewrite() does.
+struct CountedEngine {
+    std::string name;
+    // 'generation' is 0 for the first, uncounted one
+    std::function<void(
+        CellularAutomata& automata, const Board& board, Board& board_copy,
+        StepContext& context, uint64_t generation
+    )> rewrite;
+};
+
+static std::vector<CountedEngine> make_engines(int max_threads) {
+    std::vector<CountedEngine> engines;
+    std::vector<int> thread_counts { 2 };
+    if (max_threads > 2) {
+        thread_counts.push_back(max_threads);
+    }
+    for (int threads : thread_counts) {
+        auto rewriter = std::make_shared<ParallelRewriter>(threads);
+        engines.push_back({
+            std::to_string(threads) + " threads",
+            [rewriter](CellularAutomata& automata, const Board& board,
+                       Board& board_copy, StepContext& context, uint64_t) {
+                rewriter->rewrite(automata, board, board_copy, context);
+            }
+        });
+    }
+
+    auto detector = std::make_shared<CycleDetector>();
+    engines.push_back({
+        "cycle detection",
+        [detector](CellularAutomata& automata, const Board& board,
+                   Board& board_copy, StepContext& context,
+                   uint64_t generation) {
+            if (generation == 0) {
+                detector->reset(board, 0, automata.state_hash());
+            }
+            automata.rewrite(board, board_copy, context);
+            detector->step(
+                board, board_copy, context.dirty, generation + 1,
+                automata.state_hash()
+            );
+        }
+    });
+    return engines;
+}
+
+// Runs a fresh instance of a rule set for a warm-up generation and then
+// options.generations more, under 'engine' (with statistics and
+// colorizing) or the plain rewrite(). Returns the allocations of the
+// generations after the warm-up.
+static AllocationCounts measure(
+    const std::string& family, const std::string& rule,
+    const CountedEngine* engine, const AllocationCheckOptions& options
+) {
+    CellularAutomataMap registry = load_cellular_automata();
+    CellularAutomata* automata = find_cellular_automata(registry, family, rule);
+
+    Board board(options.size, options.size);
+    Board board_copy(options.size, options.size);
+    if (dynamic_cast<Turmite*>(automata) == nullptr) {
+        fill_soup(board, automata->num_states, options.seed);
+    }
+    std::array<uint32_t, 256> palette;
+    for (size_t i = 0; i < palette.size(); i++) {
+        palette[i] = 0xff000000 | (i * 0x010101);
+    }
+    std::vector<uint32_t> pixels(board.cells.size());
+    StepStats stats;
+
+    AllocationCounts start;
+    {
+        AllocationScope scope(AllocationPhase::Step);
+        for (int generation = 0; generation <= options.generations;
+             generation++) {
+            if (generation == 1) {
+                start = allocation_counts(AllocationPhase::Step);
+            }
+            StepContext context;
+            if (engine != nullptr) {
+                stats = StepStats();
+                context.palette = palette.data();
+                context.pixels = pixels.data();
+                context.stats = &stats;
+                engine->rewrite(
+                    *automata, board, board_copy, context, generation
+                );
+            } else {
+                automata->rewrite(board, board_copy, context);
+            }
+            std::swap(board, board_copy);
+        }
+    }
+    AllocationCounts end = allocation_counts(AllocationPhase::Step);
+
+    for (auto& entry : registry) {
+        for (CellularAutomata* automata : entry.second) {
+            delete automata;
+        }
+    }
+
+    AllocationCounts counts;
+    counts.allocations = end.allocations - start.allocations;
+    counts.bytes = end.bytes - start.bytes;
+    return counts;
+}
+
+int check_allocations(
+    const AllocationCheckOptions& options, std::ostream& out
+) {
+    if (!allocation_tracking) {
+        out << "allocations aren't counted in this build (configure with"
+            << " -DTOMATO_TRACK_ALLOCATIONS=ON)" << std::endl;
+        return 1;
+    }
+
+    init_neighbourhood_offsets();
+    std::vector<CountedEngine> engines = make_engines(options.threads);
+
+    std::vector<std::pair<std::string, std::string>> rule_sets;
+    CellularAutomataMap cellular_automata = load_cellular_automata();
+    for (auto& family : cellular_automata) {
+        for (CellularAutomata* automata : family.second) {
+            if ((options.family.empty() || options.family == family.first) &&
+                (options.rule.empty() || options.rule == automata->name)) {
+                rule_sets.emplace_back(family.first, automata->name);
+            }
+            delete automata;
+        }
+    }
+
+    char line[256];
+    snprintf(line, sizeof(line), "%-40s %12s %12s %14s",
+             "rule set", "allocs/gen", "allocs/cell", "bytes/gen");
+    out << line << std::endl;
+
+    double cells = static_cast<double>(options.size) * options.size;
+    int allocating = 0;
+    for (auto& rule_set : rule_sets) {
+        AllocationCounts reference =
+            measure(rule_set.first, rule_set.second, nullptr, options);
+        double generations = std::max(1, options.generations);
+        std::string name = rule_set.first + ": " + rule_set.second;
+        snprintf(line, sizeof(line), "%-40s %12.1f %12.3f %14.1f",
+                 name.c_str(), reference.allocations / generations,
+                 reference.allocations / (generations * cells),
+                 reference.bytes / generations);
+        out << line << std::endl;
+
+        // the engines should allocate exactly what the rule set does
+        for (const CountedEngine& engine : engines) {
+            AllocationCounts counts =
+                measure(rule_set.first, rule_set.second, &engine, options);
+            if (counts.allocations != reference.allocations) {
+                out << "ALLOCATES " << name << " (" << engine.name << "): "
+                    << static_cast<int64_t>(
+                           counts.allocations - reference.allocations)
+                    << " allocation(s) more than rewrite() in "
+                    << options.generations << " generations" << std::endl;
+                allocating++;
+            }
+        }
+    }
+
+    out << rule_sets.size() << " rule sets on " << options.size << "x"
+        << options.size << ", " << options.generations << " generations: "
+        << allocating << " engine(s) allocating" << std::endl;
+    return allocating;
+}
@@ -0,0 +1,27 @@
+#ifndef ALLOCATION_CHECK_H
+#define ALLOCATION_CHECK_H
+
+#include <ostream>
+#include <string>
+
+struct AllocationCheckOptions {
+    // only check this family/rule set when not empty
+    std::string family;
+    std::string rule;
+    int size = 64;
+    int generations = 10;
+    // of the largest parallel rewriter checked
+    int threads = 2;
+    unsigned seed = 1;
+};
+
+// Counts the heap allocations of every rule set's plain rewrite(), per
+// generation and per cell, and checks that the engine around it (parallel
+// rewriting with statistics and colorizing, cycle detection) allocates
+// nothing more once warmed up. Needs a build with TOMATO_TRACK_ALLOCATIONS.
+// Returns the number of engines that allocated.
+int check_allocations(
+    const AllocationCheckOptions& options, std::ostream& out
+);
+
+#endif
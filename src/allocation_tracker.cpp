@@ -0,0 +1,147 @@
+#include <atomic>
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+
+#include "./allocation_tracker.h"
+
+static thread_local AllocationPhase this_thread_phase = AllocationPhase::Other;
+static std::atomic<uint64_t> phase_allocations[ALLOCATION_PHASES];
+static std::atomic<uint64_t> phase_bytes[ALLOCATION_PHASES];
+
+const char* allocation_phase_name(AllocationPhase phase) {
+    switch (phase) {
+        case AllocationPhase::Other:
+            return "other";
+        case AllocationPhase::Step:
+            return "step";
+        case AllocationPhase::Render:
+            return "render";
+        case AllocationPhase::Gui:
+            return "gui";
+    }
+    return "";
+}
+
+AllocationPhase current_allocation_phase() {
+    return this_thread_phase;
+}
+
+AllocationCounts allocation_counts(AllocationPhase phase) {
+    AllocationCounts counts;
+    counts.allocations = phase_allocations[static_cast<int>(phase)];
+    counts.bytes = phase_bytes[static_cast<int>(phase)];
+    return counts;
+}
+
+AllocationCounts allocation_totals() {
+    AllocationCounts totals;
+    for (int phase = 0; phase < ALLOCATION_PHASES; phase++) {
+        AllocationCounts counts =
+            allocation_counts(static_cast<AllocationPhase>(phase));
+        totals.allocations += counts.allocations;
+        totals.bytes += counts.bytes;
+    }
+    return totals;
+}
+
+AllocationScope::AllocationScope(AllocationPhase phase)
+    : previous(this_thread_phase) {
+    this_thread_phase = phase;
+}
+
+AllocationScope::~AllocationScope() {
+    this_thread_phase = previous;
+}
+
+#ifdef TOMATO_TRACK_ALLOCATIONS
+
+//
+// replacements of the global operator new and delete
+//
+
+// nothing here may allocate, or it would count itself
+static void* allocate(size_t size, size_t alignment = 0) {
+    int phase = static_cast<int>(this_thread_phase);
+    phase_allocations[phase].fetch_add(1, std::memory_order_relaxed);
+    phase_bytes[phase].fetch_add(size, std::memory_order_relaxed);
+
+    if (size == 0) {
+        size = 1;
+    }
+    void* memory = nullptr;
+    if (alignment > alignof(std::max_align_t)) {
+        if (posix_memalign(&memory, alignment, size) != 0) {
+            memory = nullptr;
+        }
+    } else {
+        memory = malloc(size);
+    }
+    return memory;
+}
+
+void* operator new(size_t size) {
+    void* memory = allocate(size);
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+    void* memory = allocate(size, static_cast<size_t>(alignment));
+    if (memory == nullptr) {
+        throw std::bad_alloc();
+    }
+    return memory;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept {
+    free(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept {
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept {
+    free(memory);
+}
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef ALLOCATION_TRACKER_H
+#define ALLOCATION_TRACKER_H
+
+#include <cstdint>
+
+// What a thread is doing when it allocates. Worker threads count the
+// tasks they run under the phase of the thread that handed them out.
+enum class AllocationPhase {
+    Other,
+    Step,
+    Render,
+    Gui,
+};
+#define ALLOCATION_PHASES 4
+
+struct AllocationCounts {
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+};
+
+// Allocations are only counted when built with -DTOMATO_TRACK_ALLOCATIONS=ON,
+// which replaces the global operator new and delete. It's meant for
+// debugging: every allocation then updates shared counters.
+#ifdef TOMATO_TRACK_ALLOCATIONS
+constexpr bool allocation_tracking = true;
+#else
+constexpr bool allocation_tracking = false;
+#endif
+
+const char* allocation_phase_name(AllocationPhase phase);
+AllocationPhase current_allocation_phase();
+// allocations made by every thread so far in 'phase'
+AllocationCounts allocation_counts(AllocationPhase phase);
+// in all phases
+AllocationCounts allocation_totals();
+
+// Counts the allocations the calling thread makes in its scope under
+// 'phase', until an inner scope sets another.
+class AllocationScope {
+    private:
+        AllocationPhase previous;
+
+    public:
+        explicit AllocationScope(AllocationPhase phase);
+        ~AllocationScope();
+        AllocationScope(const AllocationScope&) = delete;
+        AllocationScope& operator=(const AllocationScope&) = delete;
+};
+
+#endif
@@ -3,6 +3,10 @@
 #include <SDL2/SDL.h>
 #include <stdio.h>
 #include <cmath>
+#include <chrono>
+#include <cfloat>
+#include <cctype>
+#include <algorithm>
 
 #include "app.h"
 #include "../imgui/imgui.h"
@@ -11,28 +15,84 @@
 #include "./automata/automata.h"
 
 // public methods
-App::App(SDL_Renderer* r): renderer(r) {
+App::App(
+    SDL_Renderer* r, const std::string& record_path,
+    const std::string& replay_path
+) : board_view(r), renderer(r) {
     cellular_automata = load_cellular_automata();
     color_schemes = load_colorschemes();
     init_neighbourhood_offsets();
+    name_phase_thread("main");
+
+    // set starting ruleset to Conway's Life, unless a replayed session
+    // started with another
+    SessionHeader session;
+    session.seed = std::default_random_engine::default_seed;
+    session.family = "Life";
+    session.rule = "Conway's Life";
+    session.rows = DEFAULT_BOARD_SIZE;
+    session.cols = DEFAULT_BOARD_SIZE;
+    if (!replay_path.empty()) {
+        session_replay = std::make_unique<SessionReplay>();
+        if (session_replay->load(
+                replay_path, cellular_automata, session_error)) {
+            session = session_replay->get_header();
+        } else {
+            session_replay.reset();
+        }
+    }
+    current_cellular_automata_family = session.family;
+    current_cellular_automata = find_cellular_automata(
+        cellular_automata, current_cellular_automata_family, session.rule
+    );
 
-    // set starting ruleset to Conway's Life
-    current_cellular_automata_family = "Life";
-    //current_cellular_automata =
-    //    cellular_automata[current_cellular_automata_family][0];
-    for (CellularAutomata* automata :
-         cellular_automata[current_cellular_automata_family]
-    ) {
-        if (automata->name == "Conway's Life") {
-            current_cellular_automata = automata;
+    simulation = std::make_unique<Simulation>(
+        current_cellular_automata, session.rows, session.cols, session.seed
+    );
+    if (!record_path.empty()) {
+        session_recorder = std::make_unique<SessionRecorder>(
+            record_path, session, cellular_automata
+        );
+        if (session_recorder->is_open()) {
+            simulation->set_observer(session_recorder.get());
+        } else {
+            session_recorder.reset();
+            session_error = "couldn't open " + record_path;
         }
     }
+    if (session_replay != nullptr) {
+        session_replay->attach(*simulation);
+        replay_start = std::chrono::steady_clock::now();
+    }
+    update_speed();
+    simulation->start();
 
     update_colors();
-    randomize_board();
+}
+
+App::~App() {
+    // the final board ends the recording
+    simulation->stop();
+    if (session_recorder != nullptr) {
+        simulation->update_frame();
+        session_recorder->finish(simulation->frame().board);
+    }
 }
 
 void App::render(const ImGuiIO& io) {
+    take_phases();
+    PhaseTimer frame_timer("frame");
+    AllocationScope allocation_scope(AllocationPhase::Render);
+    auto start_time = std::chrono::steady_clock::now();
+
+    if (!simulation->is_idle()) {
+        request_redraw();
+    } else if (redraw_frames > 0) {
+        redraw_frames--;
+    }
+    resource_usage.sample();
+    take_stats();
+
     //
     // render main drawing
     //
@@ -48,50 +108,61 @@ void App::render(const ImGuiIO& io) {
     );
     SDL_RenderClear(renderer);
 
-    auto display_width = io.DisplaySize.x;
-    auto display_height = io.DisplaySize.y;
-    auto cell_width = display_width / BOARD_COLS;
-    auto cell_height = display_height / BOARD_ROWS;
-
-    // fill in squares
-    for (size_t row = 0; row < BOARD_ROWS; row++) {
-        for (size_t col = 0; col < BOARD_COLS; col++) {
-            uint8_t val = board[row][col];
-            SDL_SetRenderDrawColor(
-                renderer,
-                colors[val][0],
-                colors[val][1],
-                colors[val][2],
-                255
+    // pick up the newest generation, if one was published since the last
+    // frame
+    drawn_input = InputStamp();
+    if (simulation->update_frame()) {
+        const Frame& frame = simulation->frame();
+        drawn_input = frame.input;
+        if (frame.board.rows != board_view.rows() ||
+            frame.board.cols != board_view.cols()) {
+            board_view.resize(frame.board.rows, frame.board.cols);
+            // e.g. a replayed resize
+            auto size = std::find(
+                board_sizes.begin(), board_sizes.end(), frame.board.rows
             );
-
-            SDL_Rect rect;
-            rect.x = col * cell_width;
-            rect.y = row * cell_height;
-            rect.w = cell_width;
-            rect.h = cell_height;
-            SDL_RenderFillRect(renderer, &rect);
+            if (size != board_sizes.end()) {
+                board_size_i = size - board_sizes.begin();
+            }
+        } else if (simulation->take_pixels(board_view.pixel_buffer())) {
+            board_view.mark_colorized(frame.dirty, true);
+        } else {
+            board_view.mark_changed(frame.dirty);
         }
     }
 
-    if (grid_enabled) {
-        SDL_SetRenderDrawColor(renderer, 70, 70, 70, 255);
-        // draw vertical grid lines
-        for (size_t col = 1; col < BOARD_COLS; col++) {
-            SDL_RenderDrawLine(renderer,
-                col * cell_width, 0,
-                col * cell_width, display_width
-            );
+    rate_window += io.DeltaTime;
+    window_frames++;
+    if (rate_window >= RATE_WINDOW_SECONDS) {
+        uint64_t generation = simulation->frame().generation;
+        measured_rate = generation >= rate_generation ?
+            (generation - rate_generation) / rate_window : 0;
+        for (int phase = 0; phase < ALLOCATION_PHASES; phase++) {
+            AllocationCounts counts =
+                allocation_counts(static_cast<AllocationPhase>(phase));
+            double per = phase == static_cast<int>(AllocationPhase::Step) ?
+                measured_rate * rate_window : window_frames;
+            per = std::max(per, 1.0);
+            allocation_rates[phase] = (counts.allocations -
+                allocations_counted[phase].allocations) / per;
+            allocation_byte_rates[phase] =
+                (counts.bytes - allocations_counted[phase].bytes) / per;
+            allocations_counted[phase] = counts;
         }
+        rate_generation = generation;
+        draw_rate = window_frames / rate_window;
+        window_frames = 0;
+        rate_window = 0;
+    }
 
-        // draw horizontal grid lines
-        for (size_t row = 1; row < BOARD_ROWS; row++) {
-            SDL_RenderDrawLine(renderer,
-                0, row * cell_height,
-                display_height, row * cell_height
-            );
-        }
+    {
+        PhaseTimer timer("board");
+        board_view.draw(
+            simulation->frame().board, io.DisplaySize.x, io.DisplaySize.y,
+            grid_enabled
+        );
     }
+    uint64_t texture_ns = phase_clock_ns();
 
     //
     // render ImGui
@@ -101,10 +172,20 @@ void App::render(const ImGuiIO& io) {
         render_gui();
     }
 
-    SDL_RenderPresent(renderer);
+    render_work_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start_time
+    ).count();
+
+    {
+        PhaseTimer present_timer("present");
+        SDL_RenderPresent(renderer);
+    }
+    record_latency(texture_ns);
 }
 
 void App::render_gui() {
+    PhaseTimer gui_timer("gui");
+    AllocationScope allocation_scope(AllocationPhase::Gui);
     ImGui::NewFrame();
 
     // tools window
@@ -112,6 +193,7 @@ void App::render_gui() {
         uint8_t old_selected_state = selected_state;
         ImGui::SetNextWindowSizeConstraints({0, 0}, {10000, 200});
         ImGui::Begin("Tools");
+        ImGui::SliderInt("Brush Size", &brush_size, 1, MAX_BRUSH_SIZE);
         ImGui::Text("Select Color");
         for (uint8_t i = 0; i < current_cellular_automata->num_states; i++) {
             ImGui::PushID(i);
@@ -179,26 +261,69 @@ void App::render_gui() {
         if (selected != -1) {
             current_color_scheme = static_cast<ColorScheme>(selected);
             update_colors();
+            if (session_recorder != nullptr) {
+                session_recorder->record_color_scheme(selected);
+            }
         }
 
         ImGui::EndCombo();
     }
 
-    int animation_speed_i = static_cast<int>(animation_speed);
-    if (ImGui::BeginCombo(
-            "Animation Speed",
-            animation_speed_names[animation_speed_i]
-    )) {
+    bool speed_changed =
+        ImGui::Checkbox("As Fast As Possible", &unlimited_speed);
+    if (unlimited_speed) {
+#ifdef TOMATO_SINGLE_THREADED
+        speed_changed |= ImGui::SliderFloat(
+            "Frame Budget", &frame_budget_ms,
+            MIN_FRAME_BUDGET_MS, FRAME_TIME_TARGET_MS, "%.0f ms"
+        );
+#endif
+    } else {
+        speed_changed |= ImGui::SliderFloat(
+            "Generations/s", &generations_per_second,
+            MIN_GENERATIONS_PER_SECOND, MAX_GENERATIONS_PER_SECOND, "%.0f",
+            ImGuiSliderFlags_Logarithmic
+        );
+    }
+    if (speed_changed) {
+        update_speed();
+    }
+    ImGui::Text(
+        "%.1f generations/s, %.2f ms per generation", measured_rate,
+        simulation->get_average_generation_ms()
+    );
+
+    if (session_replay != nullptr) {
+        ImGui::Text("%s", replay_message.c_str());
+    }
+
+    if (ImGui::Checkbox("Pause On Cycles", &pause_on_cycle)) {
+        simulation->set_pause_on_cycle(pause_on_cycle);
+    }
+    const Cycle& cycle = simulation->frame().cycle;
+    if (cycle.found() && cycle.row_shift == 0 && cycle.col_shift == 0) {
+        ImGui::SameLine();
+        ImGui::Text("Repeats every %d generation(s)", cycle.period);
+    } else if (cycle.found()) {
+        ImGui::SameLine();
+        ImGui::Text(
+            "Moves (%d, %d) every %d generation(s)",
+            cycle.row_shift, cycle.col_shift, cycle.period
+        );
+    }
+
+    if (ImGui::BeginCombo("Board Size", board_size_names[board_size_i])) {
         int selected = -1;
 
-        for (int i = 0; i < ANIMATION_SPEEDS_MAX; i++) {
-            if (ImGui::Selectable(animation_speed_names[i], animation_speed_i == i)) {
+        for (int i = 0; i < BOARD_SIZES_MAX; i++) {
+            if (ImGui::Selectable(board_size_names[i], board_size_i == i)) {
                 selected = i;
             }
         }
 
-        if (selected != -1) {
-            animation_speed = static_cast<AnimationSpeed>(selected);
+        if (selected != -1 && selected != board_size_i) {
+            board_size_i = selected;
+            resize_board(board_sizes[selected]);
         }
 
         ImGui::EndCombo();
@@ -214,12 +339,11 @@ void App::render_gui() {
 
             const char* name = family.first.c_str();
             if (ImGui::Selectable(
-                    name, name == current_cellular_automata_family)
+                    name, name == current_cellular_automata_family) &&
+                !is_replaying()
             ) {
                 current_cellular_automata_family = name;
-                current_cellular_automata = cellular_automata[name][0];
-                clear_board();
-                update_colors();
+                set_cellular_automata(cellular_automata[name][0]);
             }
             ImGui::PopID();
             i++;
@@ -240,9 +364,7 @@ void App::render_gui() {
             if (ImGui::Selectable(
                     automata->name.c_str(),
                     automata == current_cellular_automata)) {
-                clear_board();
-                current_cellular_automata = automata;
-                update_colors();
+                set_cellular_automata(automata);
             }
 
             i++;
@@ -261,70 +383,544 @@ void App::render_gui() {
         ImGui::Text("Controls:");
         ImGui::Text("SPACEBAR: start/stop animation");
         ImGui::Text("h:        toggle GUI");
+        ImGui::Text("0:        reset zoom");
+        ImGui::Text("p:        toggle performance overlay");
+        ImGui::Text("s:        toggle statistics");
+        ImGui::Text("t:        toggle timings");
+        ImGui::Text("Mouse wheel:      zoom");
+        ImGui::Text("Middle mouse drag: pan");
         ImGui::Text("ESCAPE:   close application");
 
         // end help window
         ImGui::End();
     }
 
+    if (show_performance) {
+        render_performance();
+    }
+    if (show_statistics) {
+        render_statistics();
+    }
+
+    if (show_timings) {
+        render_timings();
+    }
+
     ImGui::Render();
+    PhaseTimer draw_timer("gui draw");
     ImGuiSDL::Render(ImGui::GetDrawData());
 }
 
-// dt is the delta time in milliseconds
-void App::update(const ImGuiIO& io, int dt) {
-    if (!paused) {
-        timer += dt;
-        if (timer >= animation_speed_delays[static_cast<int>(animation_speed)]) {
-            timer = 0;
-            advance_one_generation();
+void App::render_performance() {
+    ImGui::Begin(
+        "Performance", &show_performance, ImGuiWindowFlags_AlwaysAutoResize
+    );
+
+    ImGui::Text(
+        "%.1f frames drawn/s, %.2f ms drawing", draw_rate, render_work_ms
+    );
+    ImGui::Text(
+        "CPU: %.1f%% of a core", resource_usage.get_cpu_percent()
+    );
+    if (resource_usage.has_power()) {
+        ImGui::Text("Power: %.1f W (CPU package)", resource_usage.get_watts());
+    } else {
+        ImGui::Text("Power: unavailable (RAPL not readable)");
+    }
+    ImGui::TextUnformatted(
+        simulation->is_idle() ? "Simulation idle" : "Simulation busy"
+    );
+
+    // counts for the previous frame
+    const ImGuiSDL::RenderStats& stats = ImGuiSDL::GetRenderStats();
+    ImGui::Separator();
+    if (ImGui::Checkbox("Batched GUI drawing", &gui_batched)) {
+        ImGuiSDL::SetBatchedRendering(gui_batched);
+    }
+    ImGui::Text(
+        "GUI: %d draw lists, %d draw commands", stats.DrawLists,
+        stats.DrawCommands
+    );
+    if (stats.Batched) {
+        ImGui::Text("%d geometry calls", stats.GeometryCalls);
+    } else {
+        ImGui::Text(
+            "%d triangles, %d rectangles (software)",
+            stats.FallbackTriangles, stats.FallbackRectangles
+        );
+        ImGui::Text(
+            "Cache: %zu triangles, %zu KiB, %zu hits, %zu misses",
+            stats.CachedTriangles, stats.CachedTextureBytes / 1024,
+            stats.CacheHits, stats.CacheMisses
+        );
+    }
+
+    ImGui::End();
+}
+
+void App::render_statistics() {
+    ImGui::Begin(
+        "Statistics", &show_statistics, ImGuiWindowFlags_AlwaysAutoResize
+    );
+
+    if (!have_stats) {
+        ImGui::Text("Gathered while the simulation runs");
+    } else {
+        const StepStats& stats = latest_stats.stats;
+        ImGui::Text(
+            "Generation %llu: %u births, %u deaths",
+            static_cast<unsigned long long>(latest_stats.generation),
+            stats.births, stats.deaths
+        );
+        if (stats.live.empty()) {
+            ImGui::Text("No live cells");
+        } else {
+            ImGui::Text(
+                "Live cells in rows %d-%d, columns %d-%d",
+                stats.live.min_row, stats.live.max_row,
+                stats.live.min_col, stats.live.max_col
+            );
         }
+        int states = std::min(latest_stats.num_states, STATS_STATES_SHOWN);
+        for (int state = 0; state < states; state++) {
+            ImGui::Text("State %d: %u", state, stats.population[state]);
+        }
+        if (states < latest_stats.num_states) {
+            ImGui::Text("...");
+        }
+
+        int count = plot_live.size();
+        int offset = count == STATS_PLOT_HISTORY ? plot_offset : 0;
+        ImVec2 plot_size(300, 60);
+        ImGui::PlotLines(
+            "Live", plot_live.data(), count, offset, nullptr, 0, FLT_MAX,
+            plot_size
+        );
+        ImGui::PlotLines(
+            "Births", plot_births.data(), count, offset, nullptr, 0, FLT_MAX,
+            plot_size
+        );
+        ImGui::PlotLines(
+            "Deaths", plot_deaths.data(), count, offset, nullptr, 0, FLT_MAX,
+            plot_size
+        );
     }
 
-    // if mouse was pressed and no window is focused
-    if (!ImGui::IsWindowFocused(ImGuiFocusedFlags_AnyWindow) &&
-        (io.MouseDown[0] || io.MouseDown[1])) {
-        // get the row/col from mouse position
-        double cell_width = io.DisplaySize.x / BOARD_COLS;
-        double cell_height = io.DisplaySize.y / BOARD_ROWS;
+    ImGui::Separator();
+    ImGui::InputText("File (.csv or .jsonl)", stats_path, sizeof(stats_path));
+    if (stats_writer == nullptr) {
+        if (ImGui::Button("Record")) {
+            start_recording();
+        }
+    } else {
+        if (ImGui::Button("Stop Recording")) {
+            stop_recording("Recording stopped");
+        }
+        ImGui::SameLine();
+        ImGui::Text(
+            "%llu generation(s) dropped",
+            static_cast<unsigned long long>(stats_writer->get_dropped())
+        );
+    }
+    ImGui::Text(
+        "%llu generation(s) lost before being taken",
+        static_cast<unsigned long long>(simulation->get_stats_dropped())
+    );
+    if (!stats_message.empty()) {
+        ImGui::TextUnformatted(stats_message.c_str());
+    }
+
+    ImGui::End();
+}
 
-        int clicked_col = io.MousePos.x / cell_width;
-        int clicked_row = io.MousePos.y / cell_height;
+void App::render_timings() {
+    ImGui::Begin("Timings", &show_timings, ImGuiWindowFlags_AlwaysAutoResize);
 
-        current_cellular_automata->handle_mouse_click(
-            board, selected_state, clicked_row, clicked_col, io.MouseDown[1]
+    ImGui::Text(
+        "Last %d of each phase, in ms (%llu dropped)", PHASE_WINDOW,
+        static_cast<unsigned long long>(dropped_phases())
+    );
+    // the default font is monospaced, so the figures line up
+    ImGui::Text("%-18s %9s %9s %9s %9s", "Phase", "Min", "Avg", "p50", "p99");
+    for (const PhaseSummary::Figures& phase : phase_summary.figures()) {
+        ImGui::Text(
+            "%-18s %9.3f %9.3f %9.3f %9.3f", phase.name.c_str(), phase.min_ms,
+            phase.average_ms, phase.p50_ms, phase.p99_ms
         );
     }
+
+    if (allocation_tracking) {
+        ImGui::Separator();
+        ImGui::Text("Allocations per frame (per generation for the step)");
+        ImGui::Text("%-12s %9s %12s", "Phase", "Count", "Bytes");
+        for (int phase = 0; phase < ALLOCATION_PHASES; phase++) {
+            ImGui::Text(
+                "%-12s %9.1f %12.0f",
+                allocation_phase_name(static_cast<AllocationPhase>(phase)),
+                allocation_rates[phase], allocation_byte_rates[phase]
+            );
+        }
+    }
+
+    ImGui::Separator();
+    ImGui::InputText("Trace File", trace_path, sizeof(trace_path));
+    ImGui::SliderInt("Frames", &trace_frames, 1, 1000);
+    if (trace_capture.is_capturing()) {
+        ImGui::Text("Capturing, %d frame(s) left",
+                    trace_capture.get_frames_left());
+    } else if (ImGui::Button("Capture Trace")) {
+        if (trace_capture.start(trace_path, trace_frames)) {
+            trace_message = std::string("Trace written to ") + trace_path
+                + " (open in chrome://tracing)";
+        } else {
+            trace_message = std::string("Couldn't open ") + trace_path;
+        }
+    }
+    if (!trace_capture.is_capturing() && !trace_message.empty()) {
+        ImGui::TextUnformatted(trace_message.c_str());
+    }
+
+    ImGui::Separator();
+    if (!profiler.is_running()) {
+        if (ImGui::Button("Start Profiling")) {
+            start_profiling();
+        }
+    } else {
+        if (ImGui::Button("Stop Profiling")) {
+            profiler.stop();
+            write_profile();
+        }
+        ImGui::SameLine();
+        ImGui::Text(
+            "%llu sample(s)",
+            static_cast<unsigned long long>(profiler.get_samples())
+        );
+    }
+    if (!profile_message.empty()) {
+        ImGui::TextUnformatted(profile_message.c_str());
+    }
+
+    ImGui::End();
+}
+
+// takes the phases timed since the last frame, and has them timed only
+// while they're shown or captured
+void App::take_phases() {
+    phase_events.clear();
+    collect_phases(phase_events);
+    phase_summary.add(phase_events);
+    trace_capture.add(phase_events);
+    trace_capture.end_frame();
+
+    set_phase_timing(show_timings || trace_capture.is_capturing());
+}
+
+// Records the stages from the mouse input behind the edits drawn this
+// frame to the present, on a trace track of their own: until the
+// simulation applied the edits, until the board texture was updated with
+// them, and until the frame was presented.
+void App::record_latency(uint64_t texture_ns) {
+    if (drawn_input.input_ns <= measured_input_ns || !phase_timing_enabled) {
+        return;
+    }
+    measured_input_ns = drawn_input.input_ns;
+    if (latency_track < 0) {
+        latency_track = add_phase_track("input latency");
+    }
+    uint64_t present_ns = phase_clock_ns();
+    record_phase(latency_track, "input to edit", drawn_input.input_ns,
+                 drawn_input.applied_ns);
+    record_phase(latency_track, "edit to texture", drawn_input.applied_ns,
+                 texture_ns);
+    record_phase(latency_track, "texture to present", texture_ns,
+                 present_ns);
+    record_phase(latency_track, "input to present", drawn_input.input_ns,
+                 present_ns);
+}
+
+void App::note_input(uint32_t timestamp_ms) {
+    if (pending_input_ns != 0) {
+        return;
+    }
+    // back to when SDL received the event, to the millisecond
+    uint64_t now_ns = phase_clock_ns();
+    uint64_t queued_ns = (SDL_GetTicks() - timestamp_ms) * 1000000ull;
+    pending_input_ns = queued_ns < now_ns ? now_ns - queued_ns : now_ns;
+}
+
+void App::start_profiling() {
+    if (!profiler.start()) {
+        profile_message = "Couldn't start the sampling profiler";
+        return;
+    }
+    // e.g. profile-Life-Conway_s_Life.folded
+    profile_path = "profile-" + current_cellular_automata_family + "-"
+        + current_cellular_automata->name + ".folded";
+    for (size_t i = 0; i < profile_path.size(); i++) {
+        if (!isalnum(static_cast<unsigned char>(profile_path[i])) &&
+            profile_path[i] != '-' && profile_path[i] != '.') {
+            profile_path[i] = '_';
+        }
+    }
+    profile_message = "Profiling " + current_cellular_automata->name;
+}
+
+void App::write_profile() {
+    if (profiler.write_folded(profile_path)) {
+        profile_message = "Folded stacks written to " + profile_path;
+    } else {
+        profile_message = "Couldn't write " + profile_path;
+    }
+}
+
+// takes the statistics the simulation gathered since the last frame, and
+// has it gather them only while they're shown or recorded
+void App::take_stats() {
+    simulation->set_collect_stats(
+        show_statistics || stats_writer != nullptr
+    );
+
+    GenerationStats record;
+    while (simulation->pop_stats(record)) {
+        if (stats_writer != nullptr) {
+            stats_writer->write(record);
+        }
+
+        const StepStats& stats = record.stats;
+        uint64_t live = 0;
+        for (int state = 1; state < record.num_states; state++) {
+            live += stats.population[state];
+        }
+        if (plot_live.size() < STATS_PLOT_HISTORY) {
+            plot_live.push_back(live);
+            plot_births.push_back(stats.births);
+            plot_deaths.push_back(stats.deaths);
+        } else {
+            plot_live[plot_offset] = live;
+            plot_births[plot_offset] = stats.births;
+            plot_deaths[plot_offset] = stats.deaths;
+            plot_offset = (plot_offset + 1) % STATS_PLOT_HISTORY;
+        }
+        latest_stats = record;
+        have_stats = true;
+    }
+}
+
+void App::start_recording() {
+    stats_writer = std::make_unique<StatsWriter>(
+        stats_path, current_cellular_automata->num_states
+    );
+    if (!stats_writer->is_open()) {
+        stats_writer.reset();
+        stats_message = std::string("Couldn't open ") + stats_path;
+        return;
+    }
+    stats_message = std::string("Recording to ") + stats_path;
+}
+
+void App::stop_recording(const std::string& message) {
+    if (stats_writer != nullptr) {
+        stats_writer.reset();
+        stats_message = message;
+    }
+}
+
+void App::update(const ImGuiIO& io) {
+    if (session_replay != nullptr) {
+        advance_replay();
+    }
+    bool board_hovered = !ImGui::IsWindowFocused(ImGuiFocusedFlags_AnyWindow);
+    int display_width = io.DisplaySize.x;
+    int display_height = io.DisplaySize.y;
+
+    // zoom with the mouse wheel and pan by dragging with the middle button
+    if (board_hovered && io.MouseWheel != 0) {
+        board_view.zoom_at(
+            pow(ZOOM_STEP, io.MouseWheel), io.MousePos.x, io.MousePos.y,
+            display_width, display_height
+        );
+    }
+    if (board_hovered && io.MouseDown[2]) {
+        board_view.pan(
+            io.MousePos.x - last_mouse_pos.x, io.MousePos.y - last_mouse_pos.y,
+            display_width, display_height
+        );
+    }
+    last_mouse_pos = io.MousePos;
+
+    // if mouse was pressed and no window is focused, paint a stroke from
+    // the cell painted last to the one under the mouse. Nothing is sent
+    // while the mouse stays on the same cell.
+    int clicked_row, clicked_col;
+    bool is_right_click = io.MouseDown[1];
+    if (board_hovered && (io.MouseDown[0] || io.MouseDown[1]) &&
+        !is_replaying() &&
+        board_view.window_to_cell(
+            io.MousePos.x, io.MousePos.y, display_width, display_height,
+            clicked_row, clicked_col)
+    ) {
+        bool continues_stroke =
+            stroke_active && stroke_is_right_click == is_right_click;
+        if (!continues_stroke ||
+            clicked_row != stroke_row || clicked_col != stroke_col) {
+            Command command { CommandType::Paint };
+            command.from_row = continues_stroke ? stroke_row : clicked_row;
+            command.from_col = continues_stroke ? stroke_col : clicked_col;
+            command.row = clicked_row;
+            command.col = clicked_col;
+            command.brush_size = brush_size;
+            command.state = selected_state;
+            command.is_right_click = is_right_click;
+            command.input_ns = pending_input_ns;
+            simulation->push(command);
+        }
+        stroke_active = true;
+        stroke_is_right_click = is_right_click;
+        stroke_row = clicked_row;
+        stroke_col = clicked_col;
+    } else {
+        stroke_active = false;
+    }
+    // input that didn't lead to a stroke isn't measured
+    pending_input_ns = 0;
+
+    simulation->update(render_work_ms);
+}
+
+bool App::is_idle() const {
+    return redraw_frames == 0 && simulation->is_idle() && !is_replaying();
 }
 
 void App::advance_one_generation() {
-    auto result = current_cellular_automata->rewrite(board);
-    board = result.first;
+    if (is_replaying()) {
+        return;
+    }
+    simulation->push({ CommandType::Step });
+}
 
-    bool change_made = result.second;
-    if (!change_made) {
-        paused = true;
+void App::toggle_paused() {
+    if (is_replaying()) {
+        return;
     }
+    simulation->set_paused(!simulation->is_paused());
 }
 
 // private methods
 void App::randomize_board() {
-    // don't randomize board for langton's ant
-    if (dynamic_cast<LangtonsAnt*>(current_cellular_automata) == nullptr) {
-        std::uniform_int_distribution<uint8_t> distribution(
-            0, current_cellular_automata->num_states-1);
-        for (size_t row = 0; row < BOARD_ROWS; row++) {
-            for (size_t col = 0; col < BOARD_COLS; col++) {
-                board[row][col] = distribution(random_generator);
-            }
-        }
+    if (is_replaying()) {
+        return;
     }
+    simulation->push({ CommandType::Randomize });
 }
 
 void App::clear_board() {
-    for (size_t row = 0; row < BOARD_ROWS; row++) {
-        board[row].fill(0);
+    if (is_replaying()) {
+        return;
+    }
+    simulation->push({ CommandType::Clear });
+}
+
+void App::resize_board(int size) {
+    if (is_replaying()) {
+        return;
+    }
+    Command command { CommandType::Resize };
+    command.size = size;
+    simulation->push(command);
+}
+
+void App::set_cellular_automata(CellularAutomata* automata) {
+    if (is_replaying()) {
+        return;
+    }
+    // the file has a column per state of the old rule set
+    stop_recording("Recording stopped: the rule set changed");
+    current_cellular_automata = automata;
+    // each rule set is profiled into a file of its own
+    if (profiler.is_running()) {
+        profiler.stop();
+        write_profile();
+        start_profiling();
+    }
+    Command command { CommandType::SetRule };
+    command.automata = automata;
+    simulation->push(command);
+    clear_board();
+    update_colors();
+}
+
+bool App::is_replaying() const {
+    return session_replay != nullptr &&
+        (!session_replay->is_finished() || !replay_reported);
+}
+
+// Pushes the steps and commands of the replayed session that were recorded
+// by now, follows its rule sets and color schemes, and reports once the
+// simulation is done with all of them.
+void App::advance_replay() {
+    if (replay_reported) {
+        return;
+    }
+    uint64_t time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - replay_start
+    ).count();
+    session_replay->advance(*simulation, time_us);
+
+    CellularAutomata* automata = session_replay->get_cellular_automata();
+    if (automata != current_cellular_automata) {
+        stop_recording("Recording stopped: the rule set changed");
+        current_cellular_automata = automata;
+        current_cellular_automata_family = session_replay->get_family();
+        update_colors();
+    }
+    auto color_scheme =
+        static_cast<ColorScheme>(session_replay->get_color_scheme());
+    if (color_scheme != current_color_scheme) {
+        current_color_scheme = color_scheme;
+        update_colors();
+    }
+
+    char message[256];
+    if (!session_replay->is_finished() || !simulation->is_idle()) {
+        snprintf(message, sizeof(message),
+                 "Replaying: %llu of %llu s, %llu mismatch(es)",
+                 static_cast<unsigned long long>(time_us / 1000000),
+                 static_cast<unsigned long long>(
+                     session_replay->get_duration_us() / 1000000),
+                 static_cast<unsigned long long>(
+                     session_replay->get_mismatches()));
+        replay_message = message;
+        replay_settled = false;
+        return;
+    }
+    // reported once the final board has been drawn
+    if (!replay_settled) {
+        replay_settled = true;
+        return;
     }
+    const Board& board = simulation->frame().board;
+    const char* end = !session_replay->has_end() ? "not recorded" :
+        session_replay->check_end(board) ? "matches" : "DIFFERS";
+    snprintf(message, sizeof(message),
+             "Replayed in %.1f s: %llu checksum(s), %llu mismatch(es), "
+             "final board %s",
+             time_us / 1e6,
+             static_cast<unsigned long long>(session_replay->get_checked()),
+             static_cast<unsigned long long>(
+                 session_replay->get_mismatches()),
+             end);
+    replay_message = message;
+    std::cout << replay_message << std::endl;
+    replay_reported = true;
+}
+
+void App::reset_view() {
+    board_view.reset_viewport();
+}
+
+void App::update_speed() {
+    simulation->set_target_rate(unlimited_speed ? 0 : generations_per_second);
+    simulation->set_frame_budget(frame_budget_ms);
 }
 
 void App::update_colors() {
@@ -336,6 +932,17 @@ void App::update_colors() {
             current_cellular_automata->num_states
         );
     }
+
+    // pack the colors in the pixel format of the board texture, with one
+    // entry for every possible cell value so lookups never go out of range
+    std::array<uint32_t, 256> palette;
+    palette.fill(0xff000000);
+    for (size_t i = 0; i < colors.size() && i < palette.size(); i++) {
+        palette[i] = 0xff000000
+            | (colors[i][0] << 16) | (colors[i][1] << 8) | colors[i][2];
+    }
+    board_view.set_palette(palette);
+    simulation->set_palette(palette);
 }
 
 // functions
@@ -389,283 +996,3 @@ load_colorschemes() {
         }
     }};
 }
-
-CellularAutomataMap load_cellular_automata() {
-    return {
-        {
-            "Life", {
-                new Life("2x2", "125/36"),
-                new Life("34 Life", "34/34"),
-                new Life("Amoeba", "1358/357"),
-                new Life("Assimilation", "4567/345"),
-                new Life("Coagulations", "235678/378"),
-                new Life("Conway's Life", "23/3"),
-                new Life("Coral", "45678/3"),
-                new Life("Day & Night", "34678/3678"),
-                new Life("Diamoeba", "5678/35678"),
-                new Life("Flakes", "012345678/3"),
-                new Life("Gnarl", "1/1"),
-                new Life("High Life", "23/36"),
-                new Life("Inverse Life", "34678/0123478"),
-                new Life("Long Life", "5/345"),
-                new Life("Maze", "12345/3"),
-                new Life("Mazectric", "1234/3"),
-                new Life("Move", "245/368"),
-                new Life("Pseudo Life", "238/357"),
-                new Life("Replicator", "1357/1357"),
-                new Life("Seeds (2)", "/2"),
-                new Life("Serviettes", "/234"),
-                new Life("Stains", "235678/3678"),
-                new Life("Walled Cities", "2345/45678"),
-            },
-        },
-        {
-            "Generations", {
-                new Generations("Banners", "2367/3457/5"),
-                new Generations("BelZhab", "23/23/8"),
-                new Generations("BelZhab Sediment", "145678/23/8"),
-                new Generations("Bloomerang", "234/34678/24"),
-                new Generations("Bombers", "345/24/25"),
-                new Generations("Brain 6", "6/246/3"),
-                new Generations("Brian's Brain", "/2/3"),
-                new Generations("Burst", "0235678/3468/9"),
-                new Generations("Burst II", "235678/3468/9"),
-                new Generations("Caterpillars", "124567/378/4"),
-                new Generations("Chenille", "05678/24567/6"),
-                new Generations("Circuit Genesis", "2345/1234/8"),
-                new Generations("Cooties", "23/2/8"),
-                new Generations("Ebb & Flow", "012478/36/18"),
-                new Generations("Ebb & Flow II", "012468/37/18"),
-                new Generations("Faders", "2/2/25"),
-                new Generations("Fireworks", "2/13/21"),
-                new Generations("Flaming Starbows", "347/23/8"),
-                new Generations("Frogs", "12/34/3"),
-                new Generations("Frozen Spirals", "356/23/6"),
-                new Generations("Glisserati", "035678/245678/7"),
-                new Generations("Glissergy", "035678/245678/5"),
-                new Generations("Lava", "12345/45678/8"),
-                new Generations("Lines", "012345/458/3"),
-                new Generations("LivingOnTheEdge", "345/3/6"),
-                new Generations("Meteor Guns", "01245678/3/8"),
-                new Generations("Nova", "45678/2478/25"),
-                new Generations("OrthoGo", "3/2/4"),
-                new Generations("Prairie Fire", "345/34/6"),
-                new Generations("RainZha", "2/23/8"),
-                new Generations("Rake", "3467/2678/6"),
-                new Generations("SediMental", "45678/25678/4"),
-                new Generations("Snake", "03467/25/6"),
-                new Generations("SoftFreeze", "13458/38/6"),
-                new Generations("Spirals", "2/234/5"),
-                new Generations("Star Wars", "345/2/4"),
-                new Generations("Sticks", "3456/2/6"),
-                new Generations("Swirl", "23/34/8"),
-                new Generations("ThrillGrill", "1234/34/48"),
-                new Generations("Transers", "345/26/5"),
-                new Generations("Transers II", "0345/26/6"),
-                new Generations("Wanderers", "345/34678/5"),
-                new Generations("Worms", "3467/25/6"),
-                new Generations("Xtasy", "1456/2356/16"),
-            },
-        },
-        {
-            "Cyclic", {
-                new Cyclic("313", "R1/T3/C3/NM"),
-                new Cyclic("3-Color bootstrap", "R2/T11/C3/NM"),
-                new Cyclic("Amoeba (cyclic)", "R3/T10/C2/NN"),
-                new Cyclic("Black vs White", "R5/T23/C2/NN"),
-                new Cyclic("CCA", "R1/T1/C14/NN"),
-                new Cyclic("Cubism", "R2/T5/C3/NN"),
-                new Cyclic("Cyclic Spirals", "R3/T5/C8/NM"),
-                new Cyclic("Fossil Debris", "R2/T9/C4/NM"),
-                new Cyclic("GH Macaroni", "R2/T4/C5/NM/GH"),
-                new Cyclic("GH Multistrands", "R5/T15/C6/NM/GH"),
-                new Cyclic("GH Percolation Mix", "R5/T10/C8/NM/GH"),
-                new Cyclic("GH Weak Spirals", "R4/T9/C7/NM/GH"),
-                new Cyclic("GH", "R3/T5/C8/NM/GH"),
-                new Cyclic("Imperfect", "R1/T2/C4/NM"),
-                new Cyclic("Lava Lamp", "R2/T10/C3/NM"),
-                new Cyclic("Maps", "R2/T3/C5/NN"),
-                new Cyclic("Perfect", "R1/T3/C4/NM"),
-                new Cyclic("Squarish Spirals", "R2/T2/C6/NN"),
-                new Cyclic("Stripes", "R3/T4/C5/NN"),
-                new Cyclic("Turbulent Phase", "R2/T5/C8/NM"),
-            }
-        },
-        {
-            "LargerThanLife", {
-                new LargerThanLife("Bugs", "R5,C0,M1,S34..58,B34..45,NM"),
-                new LargerThanLife("BugsMovie", "R10,C0,M1,S123..212,B123..170,NM"),
-                new LargerThanLife("Globe", "R8,C0,M0,S163..223,B74..252,NM"),
-                new LargerThanLife("Gnarl", "R1,C0,M1,S1..1,B1..1,NN"),
-                new LargerThanLife("Majority", "R4,C0,M1,S41..81,B41..81,NM"),
-                new LargerThanLife("Majorly", "R7,C0,M1,S113..225,B113..225,NM"),
-                new LargerThanLife("ModernArt", "R10,C255,M1,S2..3,B3..3,NM"),
-                new LargerThanLife("Waffle", "R7,C0,M1,S100..200,B75..170,NM"),
-            }
-        },
-        {
-            "NeumannBinary", {
-                new NeumannBinary("Aggregation", "3002000202000000000202000202000000000000000000000000000202000202000000000202000202001001111001001111111111111001001111001001111111111111111111111111111111111111111212021222020201010222221222012012010122011211000111111202122212121111111202111211"),
-                new NeumannBinary("Birds", "3010112020112112222020222020112112222112102220222220202020222020222220202020202020112102222102000200222200202102000200000012020200020000222200202200020000202000200020220000220222020000020000220222020222222222020222020000020000020222020000020000"),
-                new NeumannBinary("Colony", "3010102020102011210020210000102011210011102120210120000020210000210120000000000000112111212111110100212100200111110100110102021100021012212100200100021012200012020020222020222222222020222020222222222222222222222222222020222020222222222020222020"),
-                new NeumannBinary("Crystal2", "201101101101101101111101011001000"),
-                new NeumannBinary("Crystal3a", "3012101220100010100210200002102010000010121010100011002210000002200010012002002221111101111101000100111100100101000100000020000100000001111100100100000001100001011222222220222200200222200000222200200200022020200020000220200200200020000000000000"),
-                new NeumannBinary("Crystal3b", "3012100200100011002200012020100020021021221021012020122200021010002212102020112021111111111111100100111100100111100100100010001100001011111100100100001011100011011222222222222200200222200200222200200200022022200020020222200200200022000200020000"),
-                new NeumannBinary("Fredkin2", "201101001100101101001011001101001"),
-                new NeumannBinary("Fredkin3", "3012120201120201012201012120120201012201012120012120201201012120012120201120201012120201012201012120012120201201012120012120201120201012012120201120201012201012120201012120012120201120201012012120201120201012201012120120201012201012120012120201"),
-                new NeumannBinary("Galaxy", "3010112020112112220020220000112112220112110200220200000020220000220200000000000000002002222002000200222200200002000200000000002200002020222200200200002020200020002020220000220220000000000000220220000220220000000000000000000000000000000000000000"),
-                new NeumannBinary("Greenberg", "3010110000110110000000000000110110000110110000000000000000000000000000000000000000222222222222222222222222222222222222222222222222222222222222222222222222222222222000000000000000000000000000000000000000000000000000000000000000000000000000000000"),
-                new NeumannBinary("Honeycomb", "3010102020102002222020222020102002222002002220222220202020222020222220202020202020110112020112100202020202020112100202100002020202020200020202020202020200020200000020222020222222222020222020222222222222220202222202222020222020222202222020222020"),
-                new NeumannBinary("Knitting", "3010112020112110202020202020112110202110110002202002221020202020202002221020221010102010202010102021202021211010102021102000200021200102202021211021200102211102120020222020222222222020222020222222222222222222222222222020222020222222222020222020"),
-                new NeumannBinary("Lake", "3010112020112100202020202020112100202100010002202002220020202020202002220020220000012110202110100000202000200110100000100002022000022020202000200000022020200020000020222020222222222020222020222222222222222222222222222020222020222222222020222020"),
-                new NeumannBinary("Plankton", "3010112020112112222020222020112112222112102220222220202020222020222220202020202020100002020002010202020202020002010202010102020202020200020202020202020200020200000020220000220222020000020000220222020222222222020222020000020000020222020000020000"),
-                new NeumannBinary("Pond", "3010112020112112222020222020112112222112102220222220202020222020222220202020202020110102020102010202020202020102010202010112020202020200020202020202020200020200000020220000220222020000020000220222020222222222020222020000020000020222020000020000"),
-                new NeumannBinary("Strata", "3000000200120200000000000000000000200020100000000000000000000100000000000000000000110000000110000010000000000000000000000000000000000000000000000000000000000000000000000000020000000000000000000000000000000000000000000000000000000000000000000000"),
-                new NeumannBinary("Tanks", "3010112020112112222020222020112112222112102220222220202020222020222220202020202020110102020102010202020202020102010202010102020202020202020202020202020202020202020020222020222220200020200000222220200220222020200020000020200000200020000000000000"),
-                new NeumannBinary("Typhoon", "3010112020112112220020220000112112220112110200220200000020220000220200000000000000002002222002000200222200200002000200000000002200002020222200200200002020200020002020222020222222222020222020222222222222222222222222222020222020222222222020222020"),
-                new NeumannBinary("Wave", "3010112020112110202020202020112110202110102020202020202020202020202020202020202020112102222102000200222200202102000200000002020200020000222200202200020000202000200020220000220222020000020000220222020222222222020222020000020000020222020000020000"),
-            }
-        },
-        {
-            "RulesTable", {
-                new RulesTable(
-                    "Balloons",
-                    "1,0,1,0,0,15,0,0,0,5,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,4,4,8,4,4,4,4,4,4,0,5,5,5,5,5,7,7,9,11,0,2,2,2,2,2,2,2,2,2,0,5,5,5,5,5,13,13,9,11,0,8,8,10,8,8,8,8,8,8,0,2,2,2,2,2,9,13,9,11,0,10,10,0,10,10,10,10,10,10,0,4,14,14,14,14,14,14,14,11,0,2,12,4,12,12,12,12,12,12,0,6,6,6,6,13,13,13,9,11,0,14,14,14,12,14,14,14,14,14,0,2,2,2,2,2,2,2,2,2"
-                ),
-                new RulesTable(
-                    "Busy Brain",
-                    "1,0,0,0,0,1,2,0,2,2,2,2,0,2,2,2,1,0,2,2,2,2,0,0,0,0,0,1,2,2,1,2"
-                ),
-                new RulesTable(
-                    "Cars",
-                    "1,0,1,0,2,15,6,8,2,4,6,8,0,0,0,0,0,0,0,0,0,0,0,4,4,4,4,4,4,4,4,4,0,0,0,0,0,0,0,0,0,0,0,0,6,6,6,6,6,6,6,6,0,0,0,0,0,0,0,0,0,0,0,8,8,8,8,8,8,8,8,8,0,0,0,0,0,0,0,0,0,0,0,10,10,10,10,10,10,10,10,10,0,0,0,0,0,0,0,0,0,0,0,12,12,12,12,12,12,12,12,12,0,0,0,0,0,0,0,0,0,0,0,14,14,14,14,14,14,14,14,14,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,2,15,15"
-                ),
-                new RulesTable(
-                    "Cheops",
-                    "1,0,0,0,4,1,9,8,0,0,0,0,0,5,0,9,7,0,6,0,9,8,0,8,0,0,0,0,0,0,0,0,0,0,0,2,0,0,6,0,0,4,0,3,0,0,0,3,0,1,0,0,0,4,0,3,0,9,0,6,1,0,0,0,5,0,0,0,0,4,1,0,0,2,7,0,2,6,3,8,4,6,0,1,0,0,0,0,0,0,0,0,0,0,0,0,6,7,0,8,5,3"
-                ),
-                new RulesTable(
-                    "Cooties 2",
-                    "1,0,1,0,0,15,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,4,4,4,4,4,4,4,4,4,0,0,0,0,0,0,0,0,0,0,0,14,14,14,14,14,14,14,14,14,0,0,0,0,0,0,0,0,0,0,0,10,10,10,10,10,10,10,10,10,0,12,12,15,12,12,12,12,12,12"
-                ),
-                new RulesTable(
-                    "Crawlers",
-                    "1,0,1,0,14,3,8,0,0,0,0,0,0,2,8,0,6,0,0,3,11,0,0,0,0,0,10,0,0,0,0,0,0,0,2,0,11,0,6,0,0,0,0,6,0,0,0,4,0,9,0,0,0,6,0,8,0,0,11,10,0,8,0,10,0,0,0,11,0,0,6,0,0,0,10,0,0,0,0,5,0,0,0,2,8,0,0,0,0,0,0,0,0,6,0,5,14,0,0,0,1,0,0,0,11,6,0,0,8,8,0,0,0,8,12,0,0,0,0,0,6,5,0,8,0,0,0,0,0,8,8,0,0,1,0,0,2,6,0,6,0,5,0,0,0,0,0,0,0,0,11,0,0,0,0,0,0,0,0,0,3,9"
-                ),
-                new RulesTable(
-                    "EcoLiBra",
-                    "1,0,1,0,0,7,0,0,0,15,15,0,0,0,0,0,0,0,0,0,0,0,0,15,15,15,15,15,2,2,15,15,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,12,12,12,12,12,12,12,12,12,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,15,0,15,15,15,2,15,15,15"
-                ),
-                new RulesTable(
-                    "Empire",
-                    "1,0,1,0,0,7,1,0,0,15,15,0,0,0,0,1,1,0,0,0,0,0,0,15,15,15,15,15,2,2,15,15,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,12,12,12,12,12,12,12,12,12,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,15,0,15,15,15,2,15,15,15"
-                ),
-                new RulesTable(
-                    "Fire Sticks",
-                    "1,0,1,0,0,15,15,0,0,0,0,0,0,0,0,0,3,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,5,0,0,0,0,0,0,6,6,0,6,6,6,6,6,6,0,0,0,0,7,0,0,0,0,0,0,8,8,6,8,8,8,8,8,8,0,0,0,0,9,0,0,0,0,0,0,2,2,8,2,2,2,2,2,2,0,0,0,0,11,0,0,0,0,0,0,4,4,10,4,4,4,4,4,4,0,0,0,0,13,0,0,0,0,0,0,14,14,12,14,14,14,14,14,14,0,0,0,0,15,0,0,0,0,0,0,10,10,14,10,10,10,10,10,10,0,12,12,0,15,12,12,12,12,12"
-                ),
-                new RulesTable(
-                    "HistoricalLife",
-                    "1,0,1,0,0,0,1,0,0,0,0,0,0,2,2,1,1,2,2,2,2,2,0,2,2,2,1,2,2,2,2,2"
-                ),
-                new RulesTable(
-                    "Ladders",
-                    "1,0,1,0,6,5,0,0,2,15,5,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,8,7,15,0,15,0,0,0,0,6,0,0,0,0,0,3,0,0,0,0,0,0,0,0,0,0,0,8,0,0,0,0,0,0,0,0,0,8,4,2,5,6,0,0,0,0,0,4,0,11,0,0,0,0,0,0,0,0,0,0,0,0,0,15,4,0,0,0,8,0,15,5,0,0,0,0,0,4,10,0,0,4,5,0,0,4,0,0,8,8,0,0,12,4,6,0,0,0,0,0,10,2,10,6,6,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,9,0,11,3,0,0,9,0,0,0,14,0,0,6"
-                ),
-                new RulesTable(
-                    "Piranha",
-                    "1,0,1,0,6,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,11,0,0,0,0,0,0,0,0,7,0,6,0,0,0,0,0,0,0,0,0,0,3,0,0,0,0,9,0,0,0,6,0,0,0,0,0,0,0,0,0,0,0,3,0,0,0,0,0,5,0,0,0,0,0,0,0,0,0,8,0,4,0,0,0,0,0,0,0,0,0,0,0,0,0,0,3,0,0,0,0,0,0,0,0,0,0,0,0,1"
-                ),
-                new RulesTable(
-                    "Ran Brain",
-                    "1,0,1,0,0,5,10,0,0,5,10,0,0,0,0,5,10,0,0,0,0,15,0,0,0,0,0,0,15,15,0,0,0,0,0,14,0,0,0,0,0,0,0,0,0,4,0,0,0,0,0,0,0,2,6,2,6,2,6,2,6,2,0,2,6,2,6,2,6,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,12,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,12,0,0,0,2,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,14,7,0,0,0,0,0,0,0"
-                ),
-                new RulesTable(
-                    "Strangers",
-                    "1,0,0,0,4,1,9,8,0,0,0,0,0,5,0,9,7,0,6,0,9,8,0,2,5,0,4,0,0,0,0,0,0,0,10,2,10,0,6,0,0,4,0,3,0,10,0,3,0,1,10,0,0,4,0,3,10,9,0,6,1,0,0,0,5,0,0,0,0,4,1,0,0,2,7,0,2,6,3,8,4,6,0,1,0,0,0,0,0,0,0,0,0,0,0,0,6,7,0,8,5,3,0,9,0,0,5,0,4,0,0,5,0,0,0,0,0,0,0,9,0,0,0"
-                ),
-                new RulesTable(
-                    "WireWorld",
-                    "1,0,0,0,0,0,0,0,0,0,0,0,0,2,2,2,2,2,2,2,2,2,0,3,3,3,3,3,3,3,3,3,0,3,1,1,3,3,3,3,3,3",
-                    {{0, 0, 0}, {255, 0, 0}, {0, 0, 255}, {255, 255, 0}}
-                ),
-            }
-        },
-        {
-            "WeightedLife", {
-                new WeightedLife("Ben's Rule", "NW3,NN2,NE3,WW2,ME0,EE2,SW3,SS2,SE3,HI0,RS3,RS5,RS8,RB4,RB6,RB8"),
-                new WeightedLife("Bricks", "NW5,NN2,NE5,WW2,ME0,EE2,SW5,SS2,SE5,HI3,RS10,RS12,RS14,RS16,RB7,RB13"),
-                new WeightedLife("Border", "NW1,NN1,NE1,WW1,ME9,EE1,SW1,SS1,SE1,HI0,RS10,RS11,RS12,RS13,RS14,RS15,RS16,RB1,RB2,RB3,RB4,RB5,RB6,RB7,RB8"),
-                new WeightedLife("Bustle", "NW2,NN1,NE2,WW1,ME0,EE1,SW2,SS1,SE2,HI4,RS2,RS4,RS5,RS7,RB3"),
-                new WeightedLife("Career", "NW1,NN2,NE1,WW1,ME0,EE1,SW1,SS1,SE1,HI0,RS2,RS3,RB3"),
-                new WeightedLife("Cloud54", "NW1,NN1,NE9,WW1,ME0,EE9,SW1,SS9,SE9,HI0,RS2,RS3,RS9,RS10,RS19,RS27,RB3,RB10,RB27"),
-                new WeightedLife("Cloud75", "NW1,NN1,NE9,WW1,ME0,EE9,SW1,SS9,SE9,HI0,RS2,RS3,RS4,RS10,RS11,RS13,RS18,RS21,RS22,RS27,RS29,RS30,RS31,RS36,RS37,RS38,RS39,RS40,RB3,RB10,RB27"),
-                new WeightedLife("Conway--", "NW5,NN1,NE5,WW1,ME0,EE1,SW5,SS1,SE5,HI0,RS3,RS6,RS7,RS10,RS11,RS15,RB3,RB7,RB11,RB15"),
-                new WeightedLife("Conway++", "NW5,NN1,NE5,WW1,ME0,EE1,SW5,SS1,SE5,HI0,RS2,RS3,RS6,RS7,RS10,RS11,RS15,RS20,RB3,RB7,RB11,RB15"),
-                new WeightedLife("Conway+-1", "NW5,NN1,NE5,WW1,ME0,EE1,SW5,SS1,SE5,HI0,RS2,RS3,RS6,RS7,RS10,RS12,RS15,RB3,RB7,RB11,RB15"),
-                new WeightedLife("Conway+-2", "NW5,NN1,NE5,WW1,ME0,EE1,SW5,SS1,SE5,HI0,RS2,RS3,RS7,RS10,RS11,RS12,RS13,RS15,RB3,RB7,RB11,RB15"),
-                new WeightedLife("CrossPorpoises", "NW1,NN4,NE1,WW4,ME0,EE4,SW1,SS4,SE0,HI0,RS2,RS3,RS6,RS7,RS8,RS9,RS10,RS12,RS13,RB5"),
-                new WeightedLife("Cyclish", "NW0,NN1,NE0,WW1,ME0,EE1,SW0,SS1,SE0,HI7,RS2,RB1,RB2,RB3"),
-                new WeightedLife("Cyclones", "NW1,NN1,NE0,WW1,ME0,EE1,SW0,SS1,SE1,HI5,RS2,RS4,RS5,RB2,RB3,RB4,RB5"),
-                new WeightedLife("Dragon", "NW5,NN1,NE5,WW1,ME0,EE1,SW5,SS1,SE5,HI0,RS1,RS2,RS7,RS8,RS12,RS15,RS18,RS20,RB7,RB11,RB12,RB13,RB20"),
-                new WeightedLife("Emergence", "NW1,NN8,NE1,WW1,ME0,EE1,SW8,SS8,SE1,HI0,RS2,RS3,RS4,RS10,RS11,RS16,RS17,RS24,RS25,RB3,RB4,RB9,RB24"),
-                new WeightedLife("Fire-flies", "NW1,NN5,NE1,WW5,ME10,EE5,SW1,SS5,SE1,HI9,RS1,RS10,RB6,RB11,RB12,RB21"),
-                new WeightedLife("Fleas", "NW5,NN1,NE5,WW1,ME0,EE1,SW5,SS1,SE5,HI0,RS2,RS3,RS6,RS7,RS10,RS11,RS15,RS20,RB2,RB11"),
-                new WeightedLife("Fleas2", "NW5,NN1,NE5,WW1,ME0,EE1,SW5,SS1,SE5,HI0,RS1,RS2,RS5,RS7,RS10,RS11,RB2,RB4,RB8,RB11"),
-                new WeightedLife("NoFleas2", "NW5,NN1,NE5,WW1,ME0,EE1,SW5,SS1,SE5,HI0,RS2,RS3,RS5,RS6,RS7,RS10,RS11,RB2,RB4,RB8,RB11"),
-                new WeightedLife("FroggyHex", "NW4,NN1,NE0,WW1,ME0,EE4,SW0,SS4,SE1,HI0,RS1,RS6,RS8,RB5,RB6"),
-                new WeightedLife("Frost M", "NW1,NN1,NE1,WW1,ME0,EE1,SW1,SS1,SE1,HI25,RB1"),
-                new WeightedLife("Frost N", "NW0,NN1,NE0,WW1,ME0,EE1,SW0,SS1,SE0,HI25,RB1"),
-                new WeightedLife("Gnats", "NW9,NN1,NE9,WW1,ME0,EE1,SW9,SS1,SE9,HI0,RS0,RS1,RS2,RS11,RS19,RB11,RB19"),
-                new WeightedLife("HexParity", "NW1,NN1,NE0,WW1,ME0,EE1,SW0,SS1,SE1,HI0,RS0,RS2,RS4,RS6,RB1,RB3,RB5"),
-                new WeightedLife("Hexrule b2o", "NW1,NN2,NE0,WW32,ME0,EE4,SW0,SS16,SE8,HI0,RS5,RS7,RS10,RS11,RS13,RS14,RS15,RS17,RS19,RS20,RS21,RS22,RS23,RS25,RS26,RS27,RS28,RS29,RS30,RS34,RS35,RS37,RS38,RS39,RS40,RS41,RS42,RS43,RS44,RS45,RS46,RS49,RS50,RS51,RS52,RS53,RS54,RS56,RS57,RS58,RS60,RB3,RB6,RB12,RB24,RB33,RB48"),
-                new WeightedLife("Hextenders", "NW1,NN1,NE0,WW1,ME0,EE1,SW0,SS1,SE1,HI10,RS1,RS3,RS4,RS5,RB2,RB3"),
-                new WeightedLife("Hex Inverse Fire", "NW4,NN1,NE0,WW1,ME0,EE4,SW0,SS4,SE1,HI0,RS2,RS3,RS6,RS7,RS8,RS9,RS11,RS12,RS13,RS14,RS15,RB5,RB10,RB11,RB14,RB15"),
-                new WeightedLife("HGlass", "NW0,NN2,NE0,WW8,ME1,EE16,SW0,SS4,SE0,HI0,RS1,RS2,RS3,RS11,RS21,RS25,RS29,RS30,RS31,RB1,RB2,RB3,RB11,RB21,RB25,RB29,RB30,RB31"),
-                new WeightedLife("Hogs", "NW0,NN2,NE3,WW3,ME0,EE2,SW2,SS3,SE0,HI0,RS2,RS3,RS4,RS6,RB5,RB6"),
-                new WeightedLife("Jitters", "NW-1,NN-1,NE5,WW5,ME0,EE5,SW5,SS-1,SE-1,HI0,RS4,RS14,RB1,RB4,RB9"),
-                new WeightedLife("Lemmings", "NW1,NN2,NE1,WW2,ME0,EE2,SW1,SS3,SE1,HI0,RS3,RS4,RS5,RS6,RB4"),
-                new WeightedLife("Linguini", "NW9,NN1,NE9,WW1,ME0,EE1,SW9,SS1,SE9,HI0,RS2,RS3,RS4,RS9,RS10,RS11,RS19,RS20,RB11,RB18"),
-                new WeightedLife("Madness", "NW2,NN3,NE2,WW3,ME0,EE3,SW2,SS3,SE2,HI0,RS8,RS10,RS12,RS14,RB5,RB8,RB13"),
-                new WeightedLife("MazeMakers", "NW4,NN4,NE1,WW4,ME0,EE4,SW1,SS4,SE1,HI0,RS2,RS3,RS6,RS7,RS8,RS9,RS10,RS12,RS13,RB5"),
-                new WeightedLife("MidgeDN", "NW2,NN2,NE2,WW1,ME0,EE1,SW2,SS1,SE2,HI9,RS0,RS2,RS3,RB4,RB5,RB6"),
-                new WeightedLife("Midges", "NW1,NN2,NE1,WW2,ME3,EE2,SW1,SS2,SE1,HI4,RS3,RS5,RS6,RB4,RB5,RB6"),
-                new WeightedLife("MikesAnts", "NW0,NN1,NE1,WW1,ME0,EE0,SW1,SS1,SE1,HI0,RS4,RS5,RB2,RB5,RB6"),
-                new WeightedLife("Mosquito", "NW-1,NN-1,NE5,WW5,ME0,EE5,SW5,SS-1,SE-1,HI0,RS3,RS4,RS8,RS9,RB2,RB3,RB9"),
-                new WeightedLife("Mosquito2", "NW-1,NN-1,NE5,WW5,ME0,EE5,SW5,SS-1,SE-1,HI0,RS3,RS4,RS8,RS9,RB3,RB6,RB9,RB18"),
-                new WeightedLife("Navaho1", "NW4,NN1,NE4,WW5,ME7,EE5,SW4,SS1,SE4,HI12,RS8,RS9,RS11,RB2,RB5"),
-                new WeightedLife("Nocturne", "NW1,NN1,NE0,WW1,ME0,EE1,SW0,SS1,SE1,HI4,RS1,RS6,RB2,RB3,RB4"),
-                new WeightedLife("Parity", "NW0,NN1,NE0,WW1,ME1,EE1,SW0,SS1,SE0,HI0,RS1,RS3,RS5,RB1,RB3,RB5"),
-                new WeightedLife("Pictures", "NW0,NN1,NE0,WW1,ME0,EE1,SW0,SS1,SE0,HI0,RS1,RS2,RS3,RB2,RB3,RB4"),
-                new WeightedLife("PicturesH", "NW0,NN1,NE0,WW1,ME0,EE1,SW0,SS1,SE0,HI9,RS1,RS2,RS3,RB2,RB3,RB4"),
-                new WeightedLife("Pinwheels", "NW1,NN1,NE0,WW1,ME0,EE1,SW0,SS1,SE1,HI7,RS2,RB2,RB3"),
-                new WeightedLife("PipeFleas", "NW5,NN1,NE5,WW1,ME0,EE1,SW5,SS1,SE5,HI3,RS3,RS4,RS7,RS11,RS12,RS13,RS14,RS15,RS17,RS18,RS20,RS22,RS23,RS25,RB6,RB10"),
-                new WeightedLife("PreHogs", "NW2,NN3,NE0,WW3,ME0,EE2,SW0,SS2,SE3,HI0,RS3,RS4,RS6,RB5,RB6"),
-                new WeightedLife("PuttPutt", "NW9,NN1,NE9,WW1,ME0,EE1,SW9,SS1,SE9,HI0,RS1,RS2,RS3,RS4,RS9,RS18,RS27,RS36,RS40,RB2,RB4,RB11,RB18,RB19,RB36,RB40"),
-                new WeightedLife("SEmigration", "NW5,NN1,NE5,WW1,ME0,EE0,SW5,SS0,SE5,HI0,RS2,RS3,RS6,RS7,RS10,RS11,RS12,RB7,RB11,RB12,RB16"),
-                new WeightedLife("Simple", "NW5,NN1,NE5,WW1,ME0,EE1,SW5,SS1,SE5,HI0,RS1,RS5,RB2,RB10"),
-                new WeightedLife("Simple hex crystal", "NW1,NN1,NE0,WW1,ME0,EE0,SW0,SS0,SE0,HI0,RS1,RS2,RS3,RB2,RB4"),
-                new WeightedLife("Simple Inverse", "NW5,NN1,NE5,WW1,ME0,EE1,SW5,SS1,SE5,HI0,RS1,RS4,RS5,RS8,RS9,RS12,RS13,RS16,RS17,RS18,RS19,RS20,RS21,RS23,RS24,RB2,RB9,RB10,RB13,RB14,RB17,RB18,RB21,RB22,RB24"),
-                new WeightedLife("Simple Inverse Fire", "NW5,NN1,NE5,WW1,ME0,EE1,SW5,SS1,SE5,HI0,RS1,RS5,RS9,RS13,RS17,RS18,RS19,RS21,RS23,RS24,RB2,RB4,RB8,RB9,RB10,RB12,RB13,RB14,RB16,RB17,RB18,RB20,RB21,RB22,RB24"),
-                new WeightedLife("Stampede", "NW1,NN3,NE0,WW3,ME0,EE3,SW1,SS3,SE0,HI8,RS4,RS6,RS9,RS10,RB4,RB7"),
-                new WeightedLife("Starburst", "NW1,NN2,NE1,WW2,ME0,EE2,SW1,SS2,SE1,HI0,RS2,RS4,RS6,RB4"),
-                new WeightedLife("Starbursts2", "NW1,NN2,NE1,WW2,ME0,EE2,SW1,SS2,SE1,HI0,RS2,RS4,RS5,RS6,RB4"),
-                new WeightedLife("Stream", "NW0,NN1,NE0,WW1,ME0,EE4,SW0,SS4,SE1,HI0,RS1,RS3,RS4,RS7,RS8,RS9,RS10,RS11,RB5,RB7,RB8,RB10,RB11"),
-                new WeightedLife("UpDown1", "NW1,NN1,NE1,WW4,ME0,EE4,SW4,SS4,SE4,HI0,RS2,RS4,RS5,RS6,RS9,RS12,RS16,RS20,RB3,RB6,RB9,RB12"),
-                new WeightedLife("UpDown2", "NW1,NN5,NE1,WW1,ME0,EE1,SW5,SS5,SE5,HI0,RS2,RS3,RS7,RS10,RS11,RS12,RS15,RB3,RB7,RB11,RB15"),
-                new WeightedLife("Upstream", "NW1,NN3,NE0,WW4,ME0,EE4,SW1,SS3,SE0,HI10,RS4,RS6,RS9,RS10,RB4,RB7"),
-                new WeightedLife("Vineyard", "NW1,NN4,NE1,WW4,ME0,EE4,SW0,SS4,SE0,HI0,RS2,RS6,RS8,RS9,RS10,RS12,RS13,RB5"),
-                new WeightedLife("Vineyard2", "NW1,NN4,NE1,WW4,ME0,EE4,SW0,SS4,SE0,HI0,RS2,RS8,RS9,RS10,RS12,RS13,RB5"),
-                new WeightedLife("Weevils", "NW3,NN3,NE1,WW1,ME0,EE1,SW1,SS3,SE3,HI0,RS1,RS2,RS3,RS4,RB5,RB6,RB14"),
-                new WeightedLife("Weighted Brain", "NW2,NN3,NE2,WW3,ME-5,EE3,SW2,SS3,SE2,HI3,RS3,RS4,RS7,RB4,RB5,RB8"),
-                new WeightedLife("Y_Chromosome", "NW1,NN1,NE0,WW1,ME0,EE1,SW0,SS1,SE1,HI3,RS2,RB2"),
-                new WeightedLife("ZipperMakers", "NW1,NN0,NE1,WW0,ME0,EE4,SW1,SS4,SE1,HI0,RS2,RS3,RS6,RS7,RS8,RS9,RS10,RS12,RS13,RB5"),
-            }
-        },
-        {
-            "Ants", {
-                new LangtonsAnt(),
-            }
-        }
-    };
-}
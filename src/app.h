@@ -5,19 +5,45 @@
 #include <cstdint>
 #include <unordered_map>
 #include <array>
-#include <random>
+#include <memory>
 
 #include "../imgui/imgui.h"
 #include "./common.h"
+#include "./board_view.h"
+#include "./simulation.h"
+#include "./resource_usage.h"
+#include "./stats_writer.h"
+#include "./phase_timer.h"
+#include "./sampling_profiler.h"
+#include "./allocation_tracker.h"
+#include "./session.h"
 
-#define ANIMATION_SPEEDS_MAX 5
-enum class AnimationSpeed {
-    Slow,
-    Medium,
-    Fast,
-    VeryFast,
-    Lightning,
-};
+// range of the generations per second slider
+#define MIN_GENERATIONS_PER_SECOND 1
+#define MAX_GENERATIONS_PER_SECOND 1000
+
+#define BOARD_SIZES_MAX 6
+
+// a brush of size n paints the cells within n-1 cells of the stroke
+#define MAX_BRUSH_SIZE 32
+
+// interval over which the generations per second are measured
+#define RATE_WINDOW_SECONDS 0.5
+
+// frames drawn after the last input or change to the board, so that ImGui
+// can settle (e.g. hover highlights) before the window goes idle
+#define REDRAW_FRAMES 3
+// while idle, the window still wakes up this often to refresh the
+// performance overlay
+#define IDLE_WAIT_MS 500
+
+// generations plotted by the statistics window
+#define STATS_PLOT_HISTORY 500
+// states whose population the statistics window lists
+#define STATS_STATES_SHOWN 16
+
+// zoom factor of one mouse wheel step
+#define ZOOM_STEP 1.25
 
 #define COLORSCHEMES_MAX 2
 enum class ColorScheme {
@@ -25,7 +51,6 @@ enum class ColorScheme {
     RedGradient,
 };
 
-CellularAutomataMap load_cellular_automata();
 std::vector<std::array<uint8_t, 3>> get_color_subset(
         const std::vector<std::array<uint8_t, 3>>& colors, size_t states
 );
@@ -35,18 +60,99 @@ load_colorschemes();
 class App {
     private:
         // members
-        Board board{};
-        std::default_random_engine random_generator;
-        int timer = 0;
+        // computes the generations; the board being drawn is its newest
+        // frame
+        std::unique_ptr<Simulation> simulation;
         bool grid_enabled = true;
 
         uint8_t selected_state = 0;
         int brush_size = 1;
+        // the cell the current paint stroke last reached
+        bool stroke_active = false;
+        bool stroke_is_right_click = false;
+        int stroke_row = 0;
+        int stroke_col = 0;
+        // the oldest mouse input since the last update, in phase_clock_ns(),
+        // which the next stroke sent carries along to measure latency
+        uint64_t pending_input_ns = 0;
+        // the input behind the edits in the frame being drawn, and the
+        // newest input measured so far
+        InputStamp drawn_input;
+        uint64_t measured_input_ns = 0;
+        // trace track of the input-to-present latencies, once added
+        int latency_track = -1;
 
-        std::array<const char*, ANIMATION_SPEEDS_MAX> animation_speed_names
-            {"Slow", "Medium", "Fast", "Very Fast", "Lightning"};
-        std::array<int, ANIMATION_SPEEDS_MAX> animation_speed_delays
-            {250, 150, 100, 50, 0};
+        // speed, as a target number of generations per second or as many
+        // as possible
+        bool unlimited_speed = false;
+        float generations_per_second = 10;
+        float frame_budget_ms = FRAME_TIME_TARGET_MS;
+        // pause once the board repeats an earlier generation
+        bool pause_on_cycle = true;
+
+        // generations per second actually reached, measured over
+        // RATE_WINDOW_SECONDS
+        float measured_rate = 0;
+        float rate_window = 0;
+        uint64_t rate_generation = 0;
+        // time the last frame spent drawing, without waiting for vsync
+        double render_work_ms = 0;
+        // frames drawn per second, measured alongside measured_rate
+        float draw_rate = 0;
+        int window_frames = 0;
+        // frames left to draw before the window may go idle
+        int redraw_frames = REDRAW_FRAMES;
+        ResourceUsage resource_usage;
+
+        // statistics of the last STATS_PLOT_HISTORY generations, for the
+        // plots; once full, the oldest is at plot_offset
+        std::vector<float> plot_live;
+        std::vector<float> plot_births;
+        std::vector<float> plot_deaths;
+        int plot_offset = 0;
+        GenerationStats latest_stats;
+        bool have_stats = false;
+        // recording of the statistics to a file
+        std::unique_ptr<StatsWriter> stats_writer;
+        char stats_path[256] = "stats.csv";
+        std::string stats_message;
+
+        // timings of the phases of a frame and of the simulation, and
+        // traces of them
+        PhaseSummary phase_summary;
+        std::vector<PhaseEvent> phase_events;
+        TraceCapture trace_capture;
+        char trace_path[256] = "trace.json";
+        int trace_frames = 120;
+        std::string trace_message;
+        // sampling profiler, writing a file of folded stacks per rule set
+        SamplingProfiler profiler;
+        // where the stacks sampled since the last file are written
+        std::string profile_path;
+        std::string profile_message;
+        // allocations per frame (per generation for the step) in each
+        // phase, measured alongside measured_rate, when they're counted
+        std::array<AllocationCounts, ALLOCATION_PHASES> allocations_counted;
+        std::array<double, ALLOCATION_PHASES> allocation_rates {};
+        std::array<double, ALLOCATION_PHASES> allocation_byte_rates {};
+
+        // the session being recorded or replayed, if any. A replay drives
+        // the simulation by itself, so input that would change the board
+        // is ignored until it's done.
+        std::unique_ptr<SessionRecorder> session_recorder;
+        std::unique_ptr<SessionReplay> session_replay;
+        std::chrono::steady_clock::time_point replay_start;
+        bool replay_settled = false;
+        bool replay_reported = false;
+        std::string replay_message;
+        std::string session_error;
+
+        std::array<const char*, BOARD_SIZES_MAX> board_size_names
+            {"100x100", "256x256", "512x512", "1024x1024", "2048x2048",
+             "4096x4096"};
+        std::array<int, BOARD_SIZES_MAX> board_sizes
+            {100, 256, 512, 1024, 2048, 4096};
+        int board_size_i = 0;
 
         // color scheme
         std::array<const char*, COLORSCHEMES_MAX> color_scheme_names
@@ -55,6 +161,10 @@ class App {
         ColorScheme current_color_scheme = ColorScheme::Greyscale;
         ColorPalette colors;
 
+        // draws the board through the zoom/pan viewport
+        BoardView board_view;
+        ImVec2 last_mouse_pos;
+
         // cellular automata and automata family
         CellularAutomataMap cellular_automata;
         CellularAutomata* current_cellular_automata;
@@ -64,23 +174,58 @@ class App {
         void randomize_board();
         void clear_board();
         void render_gui();
+        void render_performance();
+        void render_statistics();
+        void render_timings();
+        void take_phases();
+        void record_latency(uint64_t texture_ns);
+        void start_profiling();
+        void write_profile();
+        void take_stats();
+        bool is_replaying() const;
+        void advance_replay();
+        void start_recording();
+        void stop_recording(const std::string& message);
         void update_colors();
+        void resize_board(int size);
+        void set_cellular_automata(CellularAutomata* automata);
+        void update_speed();
 
     public:
         // members
         SDL_Renderer* renderer;
-        AnimationSpeed animation_speed = AnimationSpeed::Fast;
-        bool paused = true;
         bool show_gui = true;
         bool show_help_menu = false;
+        bool show_performance = false;
+        bool show_statistics = false;
+        bool show_timings = false;
+        // whether the GUI is drawn with SDL_RenderGeometry where supported,
+        // or always by the software fallback (for comparing the two)
+        bool gui_batched = true;
+
+        // constructor; records the session to 'record_path' or replays the
+        // one at 'replay_path' if given
+        App(SDL_Renderer* r, const std::string& record_path = "",
+            const std::string& replay_path = "");
+        ~App();
 
-        // constructor
-        App(SDL_Renderer* r);
+        // why the session couldn't be recorded or replayed, if it couldn't
+        const std::string& get_session_error() const { return session_error; }
 
         // functions
         void render(const ImGuiIO& io);
-        void update(const ImGuiIO& io, int dt);
+        void update(const ImGuiIO& io);
+        // Whether nothing on screen can change until the next input event,
+        // so the main loop can wait for one instead of drawing.
+        bool is_idle() const;
+        // draws the next few frames, after input that may change the board,
+        // viewport or GUI
+        void request_redraw() { redraw_frames = REDRAW_FRAMES; }
+        // a mouse event arrived, at SDL's 'timestamp_ms'
+        void note_input(uint32_t timestamp_ms);
         void advance_one_generation();
+        void toggle_paused();
+        void reset_view();
 };
 
 #endif
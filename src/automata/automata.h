@@ -20,7 +20,10 @@ protected:
     std::vector<uint8_t> survive_numbers;
     std::vector<uint8_t> birth_numbers;
 public:
-    virtual std::pair<Board, bool> rewrite(const Board& board) override;
+    virtual void rewrite_rows(
+        const Board& board, Board& board_copy, StepContext& context,
+        int first_row, int last_row
+    ) override;
 
     Generations(std::string name, std::string rules);
 };
@@ -50,7 +53,10 @@ protected:
     int threshold;
     bool greenberg_hastings;
 public:
-    virtual std::pair<Board, bool> rewrite(const Board& board) override;
+    virtual void rewrite_rows(
+        const Board& board, Board& board_copy, StepContext& context,
+        int first_row, int last_row
+    ) override;
 
     Cyclic(std::string name, std::string rules);
 };
@@ -72,14 +78,18 @@ public:
 //     N5,C0,M1,S3..20,B1..4,NM
 class LargerThanLife: public CellularAutomata {
 protected:
-    int range;
-    bool count_center_cell;
+    // 0 (rejected) unless given
+    int range = 0;
+    bool count_center_cell = false;
     std::vector<uint8_t> survive_numbers;
     std::vector<uint8_t> birth_numbers;
-    NeighbourhoodType neighbourhood_type;
+    NeighbourhoodType neighbourhood_type = NeighbourhoodType::Moore;
 
 public:
-    virtual std::pair<Board, bool> rewrite(const Board& board) override;
+    virtual void rewrite_rows(
+        const Board& board, Board& board_copy, StepContext& context,
+        int first_row, int last_row
+    ) override;
 
     LargerThanLife(std::string name, std::string rules);
 };
@@ -117,7 +127,10 @@ protected:
     std::vector<uint8_t> transition_table;
 
 public:
-    virtual std::pair<Board, bool> rewrite(const Board& board) override;
+    virtual void rewrite_rows(
+        const Board& board, Board& board_copy, StepContext& context,
+        int first_row, int last_row
+    ) override;
 
     // Rules taken as a string of 1-digit integers where the first digit
     // represents the number of states (2, 3 or 4), and the following digits
@@ -150,7 +163,10 @@ protected:
     // accessed using table[<cell state>][<number of neighbours firing>]
     std::vector<std::vector<int>> table;
 public:
-    virtual std::pair<Board, bool> rewrite(const Board& board) override;
+    virtual void rewrite_rows(
+        const Board& board, Board& board_copy, StepContext& context,
+        int first_row, int last_row
+    ) override;
 
     RulesTable(std::string name, std::string rules);
     RulesTable(
@@ -177,25 +193,97 @@ protected:
     std::vector<uint8_t> survive_numbers;
 
 public:
-    virtual std::pair<Board, bool> rewrite(const Board& board) override;
+    virtual void rewrite_rows(
+        const Board& board, Board& board_copy, StepContext& context,
+        int first_row, int last_row
+    ) override;
 
     WeightedLife(std::string name, std::string rules);
 };
 
-class LangtonsAnt: public CellularAutomata {
+// Rules are either a turn string or a turmite transition table.
+//
+// A turn string holds one of the characters L, R, U or N (left, right,
+// u-turn, no turn) per cell color. An ant standing on color c turns as given
+// by the c-th character, advances the square to color c+1 (wrapping around)
+// and moves forward one square. "RL" is Langton's Ant.
+//
+// A transition table uses the notation {{{c,t,s},...},...} where the outer
+// list is indexed by the internal state of the ant and the inner lists by the
+// color of the square it stands on. Each triple gives the color to write, the
+// turn to make (1 = none, 2 = right, 4 = u-turn, 8 = left) and the next
+// internal state of the ant.
+//
+// examples:
+//     RLLR
+//     {{{1,8,1},{1,8,1}},{{1,2,1},{0,1,0}}}
+//
+// Ants are drawn using the highest state (num_states-1), so cell colors are
+// in the range [0..num_states-2].
+class Turmite: public CellularAutomata {
 protected:
-    std::pair<int, int> ant_pos { BOARD_ROWS / 2, BOARD_COLS / 2 };
-    Direction ant_direction { Direction::Up };
-    // track the state of the square the ant is on here, since we need to
+    uint8_t num_colors;
+    uint8_t num_ant_states;
+
+    // transition table, indexed by [ant state * num_colors + square color]
+    std::vector<uint8_t> write_colors;
+    std::vector<uint8_t> turns;     // in clockwise quarter turns
+    std::vector<uint8_t> next_ant_states;
+
+    // The ants are stored as parallel arrays so that each step is a handful
+    // of tight loops over contiguous memory. An ant is stepped in two phases:
+    // first every ant looks up its transition and moves, then the colors it
+    // left behind are written in ascending ant index. When several ants leave
+    // the same square in one generation the ant with the highest index
+    // decides its color, so the result never depends on anything but the
+    // order the ants were added in.
+    std::vector<int> ant_rows;
+    std::vector<int> ant_cols;
+    std::vector<uint8_t> ant_directions;
+    std::vector<uint8_t> ant_states;
+    // track the color of the square each ant is on, since we need to
     // set it to a different state on the board in order to display the ant
-    uint8_t ant_square_state = 0;
+    std::vector<uint8_t> ant_square_colors;
+    // scratch space for the colors written by the current step
+    std::vector<uint8_t> ant_writes;
+
+    int num_initial_ants;
+    // size of the board the initial ants were placed on
+    int placed_rows = 0;
+    int placed_cols = 0;
+
+    void parse_turn_string(const std::string& rules);
+    void parse_transition_table(const std::string& rules);
+    void place_ants(const Board& board);
+    void add_ant(int row, int col, Direction direction);
+    uint8_t ant_display_state() const { return num_colors; }
 
 public:
-    virtual std::pair<Board, bool> rewrite(const Board& board) override;
+    // the ants move one after the other, so a generation can only be
+    // computed as a whole
+    virtual bool can_rewrite_rows() const override { return false; }
+    // the ants' positions, directions, states and squares
+    virtual uint64_t state_hash() const override;
+    // clicks add and remove ants
+    virtual bool click_changes_state() const override { return true; }
+    virtual void rewrite(
+        const Board& board, Board& board_copy, StepContext& context
+    ) override;
+    virtual void rewrite_rows(
+        const Board& board, Board& board_copy, StepContext& context,
+        int first_row, int last_row
+    ) override;
     virtual void handle_mouse_click(
         Board& board, int selected_state, int row, int col, bool is_right_click
     ) override;
 
+    // num_ants ants are placed on the board, the first in the center facing
+    // up and the others at pseudo-random (but always the same) positions
+    Turmite(std::string name, std::string rules, int num_ants = 1);
+};
+
+class LangtonsAnt: public Turmite {
+public:
     LangtonsAnt();
 };
 
@@ -16,10 +16,13 @@ Cyclic::Cyclic(std::string name, std::string rules)
     }
 
     neighbourhood_range = std::stoi(rules_arr[0].substr(1));
+    check_neighbourhood_range("Cyclic", neighbourhood_range);
 
     threshold = std::stoi(rules_arr[1].substr(1));
 
-    num_states = std::stoi(rules_arr[2].substr(1));
+    num_states = check_num_states(
+        "Cyclic", std::stoi(rules_arr[2].substr(1))
+    );
 
     if (rules_arr[3] == "NM") {
         neighbourhood_type = NeighbourhoodType::Moore;
@@ -34,30 +37,29 @@ Cyclic::Cyclic(std::string name, std::string rules)
     greenberg_hastings = rules_arr.size() == 5 && rules_arr[4] == "GH";
 }
 
-std::pair<Board, bool> Cyclic::rewrite(const Board& board) {
-    bool change_made = false;
-    Board board_copy = board;
-
-    for (size_t row = 0; row < BOARD_ROWS; row++) {
-        for (size_t col = 0; col < BOARD_COLS; col++) {
-            int next_state = (board[row][col] + 1) % num_states;
-
-            int neighbour_count = get_extended_neighbour_count(
-                board, neighbourhood_type, row, col,
-                {greenberg_hastings ?
-                    static_cast<uint8_t>(1) :
-                    static_cast<uint8_t>(next_state)},
-                neighbourhood_range
-            );
-
-            if (neighbour_count >= threshold
-                || (greenberg_hastings && board[row][col] != 0)
-            ) {
-                board_copy[row][col] = next_state;
-                change_made = true;
-            }
+void Cyclic::rewrite_rows(
+    const Board& board, Board& board_copy, StepContext& context,
+    int first_row, int last_row
+) {
+    auto next_cell_state = [&](int row, int col) {
+        uint8_t next_state = (board[row][col] + 1) % num_states;
+
+        int neighbour_count = get_extended_neighbour_count(
+            board, neighbourhood_type, row, col,
+            {greenberg_hastings ? static_cast<uint8_t>(1) : next_state},
+            neighbourhood_range
+        );
+
+        if (neighbour_count >= threshold
+            || (greenberg_hastings && board[row][col] != 0)
+        ) {
+            return next_state;
         }
-    }
 
-    return std::pair<Board, bool> {board_copy, change_made};
+        return board[row][col];
+    };
+
+    rewrite_cells(
+        board, board_copy, context, first_row, last_row, next_cell_state
+    );
 }
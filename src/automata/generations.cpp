@@ -2,6 +2,7 @@
 #include <string>
 #include <iostream>
 #include <algorithm>
+#include <cctype>
 
 #include "./automata.h"
 #include "../common.h"
@@ -41,43 +42,60 @@ Generations::Generations(std::string name, std::string rules)
         birth_numbers.push_back(n);
     }
 
-    // parse num states
+    // parse num states, which may have several digits
     {
-        int n = rules_arr[2][0] - '0';
-        if (n < 0 || n > 9) {
+        const std::string& field = rules_arr[2];
+        if (field.empty() || field.size() > 3 ||
+            !std::all_of(field.begin(), field.end(), ::isdigit)) {
             throw new std::runtime_error(
                 "Generations third field is incorrect."
             );
         }
-        num_states = n;
+        num_states = check_num_states("Generations", std::stoi(field));
     }
-}
 
-std::pair<Board, bool> Generations::rewrite(const Board& board) {
-    bool change_made = false;
-    Board board_copy = board;
+    // counts a Moore neighbourhood of range 1 can't reach
+    int max_count = neighbourhood_size(NeighbourhoodType::Moore, 1);
+    for (uint8_t n : survive_numbers) {
+        if (n > max_count) {
+            throw new std::runtime_error(
+                "Generations survival counts must be in [0..8]"
+            );
+        }
+    }
+    for (uint8_t n : birth_numbers) {
+        if (n > max_count) {
+            throw new std::runtime_error(
+                "Generations birth counts must be in [0..8]"
+            );
+        }
+    }
+}
 
-    for (size_t row = 0; row < BOARD_ROWS; row++) {
-        for (size_t col = 0; col < BOARD_COLS; col++) {
+void Generations::rewrite_rows(
+    const Board& board, Board& board_copy, StepContext& context,
+    int first_row, int last_row
+) {
+    auto next_cell_state = [&](int row, int col) {
+        uint8_t state = board[row][col];
 
-            // count neighbours
-            uint8_t neighbour_count = get_neighbour_count(
-                board, NeighbourhoodType::Moore, row, col
-            );
+        // count neighbours
+        uint8_t neighbour_count = get_neighbour_count(
+            board, NeighbourhoodType::Moore, row, col
+        );
 
-            if (board[row][col] == 0) {
-                if (contains(birth_numbers, neighbour_count)) {
-                    board_copy[row][col] = 1;
-                    change_made = true;
-                }
-            } else if (board[row][col] != 1 ||
-                       !contains(survive_numbers, neighbour_count)
-            ) {
-                board_copy[row][col] = (board[row][col] + 1) % num_states;
-                change_made = true;
+        if (state == 0) {
+            if (contains(birth_numbers, neighbour_count)) {
+                return static_cast<uint8_t>(1);
             }
+        } else if (state != 1 || !contains(survive_numbers, neighbour_count)) {
+            return static_cast<uint8_t>((state + 1) % num_states);
         }
-    }
 
-    return std::pair<Board, bool> { board_copy, change_made };
+        return state;
+    };
+
+    rewrite_cells(
+        board, board_copy, context, first_row, last_row, next_cell_state
+    );
 }
@@ -3,13 +3,19 @@
 #include "./automata.h"
 #include "../common.h"
 
+// counts are kept as uint8_t, so ranges past 255 are rejected
 std::vector<uint8_t> parse_range(std::string range) {
     auto range_arr = split(range, '.');
-    auto start = std::stoi(range_arr[0]);
+    auto start = std::stoi(range_arr.at(0));
     auto end = std::stoi(range_arr[range_arr.size()-1]);
+    if (start < 0 || end > UINT8_MAX) {
+        throw new std::runtime_error(
+            "LargerThanLife counts must be in [0..255]"
+        );
+    }
 
     std::vector<uint8_t> nums;
-    for (uint8_t i = start; i <= end; i++) {
+    for (int i = start; i <= end; i++) {
         nums.push_back(i);
     }
     return nums;
@@ -25,10 +31,10 @@ LargerThanLife::LargerThanLife(std::string name, std::string rules)
                 range = std::stoi(rule.substr(1));
                 break;
             case 'C':
-                num_states = std::stoi(rule.substr(1));
-                if (num_states < 2) {
-                    num_states = 2;
-                }
+                num_states = check_num_states(
+                    "LargerThanLife",
+                    std::max(std::stoi(rule.substr(1)), 2)
+                );
                 break;
             case 'M':
                 count_center_cell = std::stoi(rule.substr(1)) == 1;
@@ -52,31 +58,46 @@ LargerThanLife::LargerThanLife(std::string name, std::string rules)
                 throw new std::runtime_error(err);
         }
     }
+
+    check_neighbourhood_range("LargerThanLife", range);
+    int max_count = neighbourhood_size(neighbourhood_type, range) +
+        count_center_cell;
+    for (const std::vector<uint8_t>* counts :
+            { &survive_numbers, &birth_numbers }) {
+        for (uint8_t n : *counts) {
+            if (n > max_count) {
+                throw new std::runtime_error(
+                    "LargerThanLife counts must be within the neighbourhood"
+                    " size " + std::to_string(max_count)
+                );
+            }
+        }
+    }
 }
 
-std::pair<Board, bool> LargerThanLife::rewrite(const Board& board) {
-    bool change_made = false;
-    auto board_copy = board;
+void LargerThanLife::rewrite_rows(
+    const Board& board, Board& board_copy, StepContext& context,
+    int first_row, int last_row
+) {
+    auto next_cell_state = [&](int row, int col) {
+        uint8_t state = board[row][col];
 
-    for (size_t row = 0; row < BOARD_ROWS; row++) {
-        for (size_t col = 0; col < BOARD_COLS; col++) {
-            uint8_t neighbour_count = get_extended_neighbour_count(
-                board, neighbourhood_type, row, col, {1}, range
-            );
+        uint8_t neighbour_count = get_extended_neighbour_count(
+            board, neighbourhood_type, row, col, {1}, range
+        );
 
-            if (board[row][col] == 0) {
-                if (contains(birth_numbers, neighbour_count)) {
-                    board_copy[row][col] = 1;
-                    change_made = true;
-                }
-            } else if (!(board[row][col] == 1 &&
-                        contains(survive_numbers, neighbour_count))
-            ) {
-                board_copy[row][col] = (board[row][col] + 1) % num_states;
-                change_made = true;
+        if (state == 0) {
+            if (contains(birth_numbers, neighbour_count)) {
+                return static_cast<uint8_t>(1);
             }
+        } else if (!(state == 1 && contains(survive_numbers, neighbour_count))) {
+            return static_cast<uint8_t>((state + 1) % num_states);
         }
-    }
 
-    return {board_copy, change_made};
+        return state;
+    };
+
+    rewrite_cells(
+        board, board_copy, context, first_row, last_row, next_cell_state
+    );
 }
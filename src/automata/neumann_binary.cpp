@@ -46,29 +46,39 @@ NeumannBinary::NeumannBinary(std::string name, std::string rules)
                 "NeumannBinary rules can only contain digits"
             );
         }
+        if (_state >= num_states) {
+            throw new std::runtime_error(
+                "NeumannBinary transitions must be to one of its states"
+            );
+        }
         transition_table.push_back(_state);
     }
-}
 
-std::pair<Board, bool> NeumannBinary::rewrite(const Board& board) {
-    bool change_made = false;
-    auto board_copy = board;
+    // an entry for every configuration of a cell and its 4 neighbours
+    size_t configurations = pow(num_states, 5);
+    if (transition_table.size() != configurations) {
+        throw new std::runtime_error(
+            "NeumannBinary transition table must have " +
+            std::to_string(configurations) + " entries"
+        );
+    }
+}
 
-    for (size_t row = 0; row < BOARD_ROWS; row++) {
-        for (size_t col = 0; col < BOARD_COLS; col++) {
-            // get values of all neighbours
-            std::vector<uint8_t> neighbour_config =
-                get_neighbour_configuration(board, row, col);
+void NeumannBinary::rewrite_rows(
+    const Board& board, Board& board_copy, StepContext& context,
+    int first_row, int last_row
+) {
+    auto next_cell_state = [&](int row, int col) {
+        // get values of all neighbours
+        std::vector<uint8_t> neighbour_config =
+            get_neighbour_configuration(board, row, col);
 
-            int index = neighbour_config_to_index(neighbour_config, num_states);
+        int index = neighbour_config_to_index(neighbour_config, num_states);
 
-            // check before changing here so we can properly set the change_made
-            if (board[row][col] != transition_table[index]) {
-                board_copy[row][col] = transition_table[index];
-                change_made = true;
-            }
-        }
-    }
+        return transition_table[index];
+    };
 
-    return { board_copy, change_made };
+    rewrite_cells(
+        board, board_copy, context, first_row, last_row, next_cell_state
+    );
 }
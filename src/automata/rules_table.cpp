@@ -74,7 +74,27 @@ RulesTable::RulesTable(std::string name, std::string rules)
         start_index = end_index;
     }
 
-    num_states = table.size();
+    num_states = check_num_states("RulesTable", table.size());
+
+    // a column for every count of firing neighbours (and the center cell)
+    // a cell can see, and only states the table has a row for
+    size_t max_count = neighbourhood_size(neighbourhood_type, 1) +
+        count_center_cell;
+    for (const std::vector<int>& row : table) {
+        if (row.size() <= max_count) {
+            throw new std::runtime_error(
+                "RulesTable rows must cover every neighbour count"
+            );
+        }
+        for (int state : row) {
+            if (state >= num_states) {
+                throw new std::runtime_error(
+                    "RulesTable has no row for state " +
+                    std::to_string(state)
+                );
+            }
+        }
+    }
 }
 
 RulesTable::RulesTable(
@@ -84,31 +104,25 @@ RulesTable::RulesTable(
     this->color_override = std::optional(color_override);
 }
 
-std::pair<Board, bool> RulesTable::rewrite(const Board& board) {
-    bool change_made = false;
-    Board board_copy = board;
-
-    for (size_t row = 0; row < BOARD_ROWS; row++) {
-        for (size_t col = 0; col < BOARD_COLS; col++) {
-            int neighbour_count = first_bitplane_is_firing ?
-                get_neighbour_count(board, neighbourhood_type, row, col, 1) :
-                get_neighbour_count(board, neighbourhood_type, row, col);
-
-            // add center cell to neighbour_count if applicable
-            if (count_center_cell && board[row][col] == 1) {
-                neighbour_count++;
-            }
-
-            // set the current cell to its new value given by the rule table
-            board_copy[row][col] = table[board[row][col]][neighbour_count];
-
-            // check if the current cell has changed so that we can
-            // identify stagnant states
-            if (board_copy[row][col] != board[row][col]) {
-                change_made = true;
-            }
+void RulesTable::rewrite_rows(
+    const Board& board, Board& board_copy, StepContext& context,
+    int first_row, int last_row
+) {
+    auto next_cell_state = [&](int row, int col) {
+        int neighbour_count = first_bitplane_is_firing ?
+            get_neighbour_count(board, neighbourhood_type, row, col, 1) :
+            get_neighbour_count(board, neighbourhood_type, row, col);
+
+        // add center cell to neighbour_count if applicable
+        if (count_center_cell && board[row][col] == 1) {
+            neighbour_count++;
         }
-    }
 
-    return { board_copy, change_made };
+        // the new value of the cell is given by the rule table
+        return static_cast<uint8_t>(table[board[row][col]][neighbour_count]);
+    };
+
+    rewrite_cells(
+        board, board_copy, context, first_row, last_row, next_cell_state
+    );
 }
@@ -0,0 +1,304 @@
+#include <stdexcept>
+#include <random>
+#include <cctype>
+
+#include "./automata.h"
+#include "../common.h"
+
+// arbitrary, but fixed so that a rule set always starts with the same ants
+#define ANT_PLACEMENT_SEED 1234
+
+// row/col offsets of a move forward, indexed by Direction
+static const int direction_row_offsets[DIRECTIONS_MAX] { -1, 0, 1, 0 };
+static const int direction_col_offsets[DIRECTIONS_MAX] { 0, 1, 0, -1 };
+
+Turmite::Turmite(std::string name, std::string rules, int num_ants)
+    : CellularAutomata { name, rules }
+{
+    if (!rules.empty() && rules[0] == '{') {
+        parse_transition_table(rules);
+    } else {
+        parse_turn_string(rules);
+    }
+
+    num_states = num_colors + 1;
+    num_initial_ants = num_ants;
+}
+
+// (re)places the initial ants whenever the size of the board changes, since
+// the ants can't be placed before the board they walk on is known
+void Turmite::place_ants(const Board& board) {
+    if (board.rows == placed_rows && board.cols == placed_cols) {
+        return;
+    }
+    placed_rows = board.rows;
+    placed_cols = board.cols;
+
+    ant_rows.clear();
+    ant_cols.clear();
+    ant_directions.clear();
+    ant_states.clear();
+    ant_square_colors.clear();
+
+    add_ant(board.rows / 2, board.cols / 2, Direction::Up);
+
+    std::minstd_rand random_generator(ANT_PLACEMENT_SEED);
+    std::uniform_int_distribution<int> row_distribution(0, board.rows-1);
+    std::uniform_int_distribution<int> col_distribution(0, board.cols-1);
+    std::uniform_int_distribution<int> direction_distribution(
+        0, DIRECTIONS_MAX-1
+    );
+    for (int i = 1; i < num_initial_ants; i++) {
+        int row = row_distribution(random_generator);
+        int col = col_distribution(random_generator);
+        add_ant(row, col, static_cast<Direction>(
+            direction_distribution(random_generator)
+        ));
+    }
+}
+
+void Turmite::parse_turn_string(const std::string& rules) {
+    if (rules.size() < 2 || rules.size() > 16) {
+        throw new std::runtime_error(
+            "Turmite turn string must have between 2 and 16 characters"
+        );
+    }
+
+    num_colors = rules.size();
+    num_ant_states = 1;
+
+    for (size_t color = 0; color < rules.size(); color++) {
+        uint8_t turn;
+        switch (rules[color]) {
+            case 'N': turn = 0; break;
+            case 'R': turn = 1; break;
+            case 'U': turn = 2; break;
+            case 'L': turn = 3; break;
+            default:
+                throw new std::runtime_error(
+                    "Turmite turn string can only contain L, R, U and N"
+                );
+        }
+
+        write_colors.push_back((color + 1) % num_colors);
+        turns.push_back(turn);
+        next_ant_states.push_back(0);
+    }
+}
+
+void Turmite::parse_transition_table(const std::string& rules) {
+    std::string err = "Invalid transition table for Turmite " + name;
+
+    // collect the triples while checking that every ant state lists the
+    // same number of colors
+    std::vector<int> values;
+    std::vector<int> colors_per_state;
+    int depth = 0;
+    for (size_t i = 0; i < rules.size(); i++) {
+        char c = rules[i];
+        if (c == '{') {
+            depth++;
+            if (depth == 2) {
+                colors_per_state.push_back(0);
+            } else if (depth == 3) {
+                colors_per_state.back()++;
+            } else if (depth != 1) {
+                throw new std::runtime_error(err);
+            }
+        } else if (c == '}') {
+            depth--;
+        } else if (isdigit(c)) {
+            size_t end = i;
+            while (end < rules.size() && isdigit(rules[end])) {
+                end++;
+            }
+            values.push_back(std::stoi(rules.substr(i, end - i)));
+            i = end - 1;
+        } else if (c != ',' && c != ' ') {
+            throw new std::runtime_error(err);
+        }
+    }
+
+    if (depth != 0 || colors_per_state.empty() || values.size() % 3 != 0) {
+        throw new std::runtime_error(err);
+    }
+
+    int _num_colors = colors_per_state[0];
+    for (int n : colors_per_state) {
+        if (n != _num_colors) {
+            throw new std::runtime_error(err);
+        }
+    }
+    if (_num_colors < 2 || _num_colors > 16 || colors_per_state.size() > 16) {
+        throw new std::runtime_error(err);
+    }
+
+    num_colors = _num_colors;
+    num_ant_states = colors_per_state.size();
+
+    for (size_t i = 0; i < values.size(); i += 3) {
+        int color = values[i];
+        int next_state = values[i+2];
+        if (color >= num_colors || next_state >= num_ant_states) {
+            throw new std::runtime_error(err);
+        }
+
+        uint8_t turn;
+        switch (values[i+1]) {
+            case 1: turn = 0; break;
+            case 2: turn = 1; break;
+            case 4: turn = 2; break;
+            case 8: turn = 3; break;
+            default:
+                throw new std::runtime_error(err);
+        }
+
+        write_colors.push_back(color);
+        turns.push_back(turn);
+        next_ant_states.push_back(next_state);
+    }
+}
+
+void Turmite::add_ant(int row, int col, Direction direction) {
+    ant_rows.push_back(row);
+    ant_cols.push_back(col);
+    ant_directions.push_back(static_cast<uint8_t>(direction));
+    ant_states.push_back(0);
+    ant_square_colors.push_back(0);
+}
+
+void Turmite::rewrite(
+    const Board& board, Board& board_copy, StepContext& context
+) {
+    place_ants(board);
+    board_copy = board;
+    size_t num_ants = ant_rows.size();
+    uint32_t* pixels = context.pixels;
+    uint8_t ant_state = ant_display_state();
+    ant_writes.resize(num_ants);
+
+    // look up the transition of every ant and turn it. A square that no
+    // longer shows the ant has been painted over (or cleared), in which case
+    // the board wins over the remembered color.
+    for (size_t i = 0; i < num_ants; i++) {
+        uint8_t square = board[ant_rows[i]][ant_cols[i]];
+        uint8_t color = square == ant_state ? ant_square_colors[i] : square;
+        int transition = ant_states[i] * num_colors + color;
+
+        ant_writes[i] = write_colors[transition];
+        ant_directions[i] = (ant_directions[i] + turns[transition]) & 3;
+        ant_states[i] = next_ant_states[transition];
+    }
+
+    // recolor the squares the ants are leaving, in ant order
+    for (size_t i = 0; i < num_ants; i++) {
+        board_copy[ant_rows[i]][ant_cols[i]] = ant_writes[i];
+        context.dirty.include(ant_rows[i], ant_cols[i]);
+    }
+    if (pixels != nullptr) {
+        for (size_t i = 0; i < num_ants; i++) {
+            pixels[ant_rows[i] * board.cols + ant_cols[i]] =
+                context.palette[ant_writes[i]];
+        }
+    }
+
+    // move forward one square
+    for (size_t i = 0; i < num_ants; i++) {
+        int row = ant_rows[i] + direction_row_offsets[ant_directions[i]];
+        int col = ant_cols[i] + direction_col_offsets[ant_directions[i]];
+        ant_rows[i] = row < 0 ? row + board.rows :
+                      row >= board.rows ? row - board.rows : row;
+        ant_cols[i] = col < 0 ? col + board.cols :
+                      col >= board.cols ? col - board.cols : col;
+    }
+
+    // remember the colors under the ants before drawing them, so that ants
+    // arriving on the same square all see its real color
+    for (size_t i = 0; i < num_ants; i++) {
+        ant_square_colors[i] = board_copy[ant_rows[i]][ant_cols[i]];
+    }
+    for (size_t i = 0; i < num_ants; i++) {
+        board_copy[ant_rows[i]][ant_cols[i]] = ant_state;
+        context.dirty.include(ant_rows[i], ant_cols[i]);
+    }
+    if (pixels != nullptr) {
+        for (size_t i = 0; i < num_ants; i++) {
+            pixels[ant_rows[i] * board.cols + ant_cols[i]] =
+                context.palette[ant_state];
+        }
+    }
+
+    // the board was copied as a whole anyway, so counting it as a whole
+    // isn't much worse
+    if (context.stats != nullptr) {
+        count_cells(board, board_copy, *context.stats);
+    }
+}
+
+void Turmite::rewrite_rows(
+    const Board& board, Board& board_copy, StepContext& context,
+    int first_row, int last_row
+) {
+    if (first_row != 0 || last_row != board.rows) {
+        throw new std::runtime_error(
+            "Turmite " + name + " can only be rewritten as a whole"
+        );
+    }
+    rewrite(board, board_copy, context);
+}
+
+uint64_t Turmite::state_hash() const {
+    // FNV-1a, as board_checksum()
+    uint64_t hash = 0xcbf29ce484222325;
+    auto add = [&hash](uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; i++) {
+            hash = (hash ^ ((value >> (8 * i)) & 0xff)) * 0x100000001b3;
+        }
+    };
+    for (size_t i = 0; i < ant_rows.size(); i++) {
+        add(ant_rows[i], 4);
+        add(ant_cols[i], 4);
+        add(ant_directions[i], 1);
+        add(ant_states[i], 1);
+        add(ant_square_colors[i], 1);
+    }
+    return hash;
+}
+
+// left click places an ant facing up, right click removes all ants from
+// the clicked square
+void Turmite::handle_mouse_click(
+    Board& board, int, int row, int col, bool is_right_click
+) {
+    place_ants(board);
+    uint8_t ant_state = ant_display_state();
+
+    if (is_right_click) {
+        for (size_t i = ant_rows.size(); i-- > 0;) {
+            if (ant_rows[i] != row || ant_cols[i] != col) {
+                continue;
+            }
+
+            if (board[row][col] == ant_state) {
+                board[row][col] = ant_square_colors[i];
+            }
+            ant_rows.erase(ant_rows.begin() + i);
+            ant_cols.erase(ant_cols.begin() + i);
+            ant_directions.erase(ant_directions.begin() + i);
+            ant_states.erase(ant_states.begin() + i);
+            ant_square_colors.erase(ant_square_colors.begin() + i);
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < ant_rows.size(); i++) {
+        if (ant_rows[i] == row && ant_cols[i] == col) {
+            return;
+        }
+    }
+
+    add_ant(row, col, Direction::Up);
+    ant_square_colors.back() =
+        board[row][col] == ant_state ? 0 : board[row][col];
+    board[row][col] = ant_state;
+}
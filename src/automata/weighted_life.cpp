@@ -23,7 +23,7 @@ WeightedLife::WeightedLife(std::string name, std::string rules)
             }
         } else if (prefix == "HI") {
             if (value > 0) {
-                num_states = value;
+                num_states = check_num_states("WeightedLife", value);
             } else {
                 // if no history is specified, there are 2 states
                 num_states = 2;
@@ -36,32 +36,34 @@ WeightedLife::WeightedLife(std::string name, std::string rules)
     }
 }
 
-std::pair<Board, bool> WeightedLife::rewrite(const Board& board) {
-    bool change_made = false;
-    Board board_copy = board;
+void WeightedLife::rewrite_rows(
+    const Board& board, Board& board_copy, StepContext& context,
+    int first_row, int last_row
+) {
+    auto next_cell_state = [&](int row, int col) {
+        uint8_t state = board[row][col];
 
-    for (size_t row = 0; row < BOARD_ROWS; row++) {
-        for (size_t col = 0; col < BOARD_COLS; col++) {
-            int neighbour_count = get_weighted_neighbour_count(
-                board, row, col, neighbour_weights
-            );
+        int neighbour_count = get_weighted_neighbour_count(
+            board, row, col, neighbour_weights
+        );
 
-            if (board[row][col] == 0) {
-                if (contains(birth_numbers,
-                            static_cast<uint8_t>(neighbour_count))
-                ) {
-                    board_copy[row][col] = 1;
-                    change_made = true;
-                }
-            } else if (board[row][col] != 1 ||
-                       !contains(survive_numbers,
-                                 static_cast<uint8_t>(neighbour_count))
+        if (state == 0) {
+            if (contains(birth_numbers,
+                        static_cast<uint8_t>(neighbour_count))
             ) {
-                board_copy[row][col] = (board[row][col] + 1) % num_states;
-                change_made = true;
+                return static_cast<uint8_t>(1);
             }
+        } else if (state != 1 ||
+                   !contains(survive_numbers,
+                             static_cast<uint8_t>(neighbour_count))
+        ) {
+            return static_cast<uint8_t>((state + 1) % num_states);
         }
-    }
 
-    return { board_copy, change_made };
+        return state;
+    };
+
+    rewrite_cells(
+        board, board_copy, context, first_row, last_row, next_cell_state
+    );
 }
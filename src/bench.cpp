@@ -0,0 +1,562 @@
+#include <iostream>
+#include <array>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <map>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <algorithm>
+
+#include "./common.h"
+#include "./automata/automata.h"
+#include "./parallel_rewrite.h"
+#include "./perf_counters.h"
+#include "./soup.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+// Benchmarks the rewrite of every rule set (or those picked on the command
+// line) at a range of board sizes, densities and thread counts, and
+// compares the results with a baseline written by an earlier run.
+
+// a case is flagged when it got this many percent slower than the baseline
+#define DEFAULT_REGRESSION_THRESHOLD 5.0
+
+struct Options {
+    std::string family;
+    std::string rule;
+    std::vector<int> sizes { 100, 1024, 4096 };
+    std::vector<double> densities { 0.5 };
+    std::vector<int> threads {
+        1, static_cast<int>(std::max(1u, std::thread::hardware_concurrency()))
+    };
+    int repetitions = 5;
+    // each repetition runs enough generations to take at least this long
+    double min_seconds = 0.2;
+    unsigned seed = 1;
+    std::string json_path;
+    std::string csv_path;
+    std::string baseline_path;
+    double threshold = DEFAULT_REGRESSION_THRESHOLD;
+};
+
+struct Result {
+    std::string family;
+    std::string rule;
+    int size;
+    double density;
+    int threads;
+    int generations;
+    int repetitions;
+    // median and standard deviation over the repetitions
+    double ns_per_cell;
+    double ns_per_cell_stddev;
+    double generations_per_second;
+    // assuming every cell is read once and written once per generation
+    double bandwidth_gb_per_second;
+    // from the hardware counters over all the repetitions, if they could
+    // be read
+    std::optional<double> instructions_per_cycle;
+    std::optional<double> l1_misses_per_cell;
+    std::optional<double> llc_misses_per_cell;
+    std::optional<double> branch_misses_per_cell;
+};
+
+static void print_usage(const char* program) {
+    cerr << "usage: " << program << " [options]" << endl
+         << "  --family NAME        only benchmark this family" << endl
+         << "  --rule NAME          only benchmark this rule set" << endl
+         << "  --sizes N,...        board sizes (default: 100,1024,4096)"
+         << endl
+         << "  --densities D,...    fractions of live cells (default: 0.5)"
+         << endl
+         << "  --threads N,...      thread counts (default: 1 and all cores)"
+         << endl
+         << "  --repetitions N      timed repetitions per case (default: 5)"
+         << endl
+         << "  --min-time S         minimum seconds per repetition"
+         << " (default: 0.2)" << endl
+         << "  --seed N             seed of the random boards (default: 1)"
+         << endl
+         << "  --json FILE          write the results as JSON" << endl
+         << "  --csv FILE           write the results as CSV" << endl
+         << "  --baseline FILE      compare with the CSV of an earlier run"
+         << endl
+         << "  --threshold P        percent slower than the baseline that"
+         << " counts as a regression (default: 5)" << endl;
+}
+
+template<typename T>
+static std::vector<T> parse_list(const std::string& value) {
+    std::vector<T> list;
+    for (const std::string& item : split(value, ',')) {
+        std::istringstream stream(item);
+        T parsed;
+        if (!(stream >> parsed)) {
+            throw std::invalid_argument(item);
+        }
+        list.push_back(parsed);
+    }
+    return list;
+}
+
+static bool parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+
+        try {
+            if (option == "--family") {
+                options.family = value;
+            } else if (option == "--rule") {
+                options.rule = value;
+            } else if (option == "--sizes") {
+                options.sizes = parse_list<int>(value);
+            } else if (option == "--densities") {
+                options.densities = parse_list<double>(value);
+            } else if (option == "--threads") {
+                options.threads = parse_list<int>(value);
+            } else if (option == "--repetitions") {
+                options.repetitions = std::stoi(value);
+            } else if (option == "--min-time") {
+                options.min_seconds = std::stod(value);
+            } else if (option == "--seed") {
+                options.seed = std::stoul(value);
+            } else if (option == "--json") {
+                options.json_path = value;
+            } else if (option == "--csv") {
+                options.csv_path = value;
+            } else if (option == "--baseline") {
+                options.baseline_path = value;
+            } else if (option == "--threshold") {
+                options.threshold = std::stod(value);
+            } else {
+                return false;
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    auto positive = [](double value) { return value > 0; };
+    auto fraction = [](double value) { return value >= 0 && value <= 1; };
+    return options.repetitions > 0 &&
+        std::all_of(options.sizes.begin(), options.sizes.end(), positive) &&
+        std::all_of(options.densities.begin(), options.densities.end(),
+                    fraction) &&
+        std::all_of(options.threads.begin(), options.threads.end(), positive);
+}
+
+static double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start
+    ).count();
+}
+
+static Result run_case(
+    const std::string& family, CellularAutomata& automata, int size,
+    double density, ParallelRewriter& rewriter, const PerfCounters& counters,
+    const Options& options
+) {
+    // turmites start on an empty board
+    Board board(size, size);
+    Board board_copy(size, size);
+    // a 'density' fraction of the cells in a random state other than 0
+    if (dynamic_cast<Turmite*>(&automata) == nullptr &&
+        automata.num_states > 1) {
+        SoupOptions soup;
+        soup.density = density;
+        fill_soup(board, automata.num_states, options.seed, soup,
+                  &rewriter.thread_pool());
+    }
+
+    auto run = [&](int generations) {
+        for (int i = 0; i < generations; i++) {
+            StepContext context;
+            rewriter.rewrite(automata, board, board_copy, context);
+            std::swap(board, board_copy);
+        }
+    };
+
+    // warm up, and find how many generations fill a repetition
+    int generations = 0;
+    auto start = std::chrono::steady_clock::now();
+    do {
+        run(1);
+        generations++;
+    } while (seconds_since(start) < options.min_seconds);
+
+    std::vector<double> ns_per_cell;
+    double cells = static_cast<double>(size) * size;
+    // counts of all the repetitions, of the counters every one had
+    std::array<uint64_t, PERF_COUNTERS_MAX> counts {};
+    std::array<bool, PERF_COUNTERS_MAX> counted;
+    counted.fill(true);
+    for (int repetition = 0; repetition < options.repetitions; repetition++) {
+        PerfCounters::Sample counts_start = counters.read();
+        start = std::chrono::steady_clock::now();
+        run(generations);
+        ns_per_cell.push_back(
+            seconds_since(start) * 1e9 / (cells * generations)
+        );
+        PerfCounters::Sample difference =
+            PerfCounters::difference(counts_start, counters.read());
+        for (int i = 0; i < PERF_COUNTERS_MAX; i++) {
+            counted[i] = counted[i] && difference.values[i].has_value();
+            counts[i] += difference.values[i].value_or(0);
+        }
+    }
+
+    double mean = 0;
+    for (double sample : ns_per_cell) {
+        mean += sample / ns_per_cell.size();
+    }
+    double variance = 0;
+    for (double sample : ns_per_cell) {
+        variance += (sample - mean) * (sample - mean) / ns_per_cell.size();
+    }
+    std::sort(ns_per_cell.begin(), ns_per_cell.end());
+    double median = ns_per_cell[ns_per_cell.size() / 2];
+    if (ns_per_cell.size() % 2 == 0) {
+        median = (median + ns_per_cell[ns_per_cell.size() / 2 - 1]) / 2;
+    }
+
+    Result result;
+    result.family = family;
+    result.rule = automata.name;
+    result.size = size;
+    result.density = density;
+    result.threads = rewriter.threads();
+    result.generations = generations;
+    result.repetitions = options.repetitions;
+    result.ns_per_cell = median;
+    result.ns_per_cell_stddev = std::sqrt(variance);
+    result.generations_per_second = 1e9 / (median * cells);
+    result.bandwidth_gb_per_second = 2 / median;
+
+    double measured_cells = cells * generations * options.repetitions;
+    auto per_cell = [&](PerfCounter counter) -> std::optional<double> {
+        int i = static_cast<int>(counter);
+        if (!counted[i]) {
+            return std::nullopt;
+        }
+        return counts[i] / measured_cells;
+    };
+    int cycles = static_cast<int>(PerfCounter::Cycles);
+    int instructions = static_cast<int>(PerfCounter::Instructions);
+    if (counted[cycles] && counted[instructions] && counts[cycles] > 0) {
+        result.instructions_per_cycle =
+            static_cast<double>(counts[instructions]) / counts[cycles];
+    }
+    result.l1_misses_per_cell = per_cell(PerfCounter::L1DataMisses);
+    result.llc_misses_per_cell = per_cell(PerfCounter::LastLevelMisses);
+    result.branch_misses_per_cell = per_cell(PerfCounter::BranchMisses);
+    return result;
+}
+
+//
+// output
+//
+
+// identifies a case across runs
+static std::string case_key(
+    const std::string& family, const std::string& rule, int size,
+    double density, int threads
+) {
+    std::ostringstream key;
+    key << family << "/" << rule << "/" << size << "/" << density << "/"
+        << threads;
+    return key.str();
+}
+
+static std::string csv_field(const std::string& field) {
+    if (field.find_first_of(",\"") == std::string::npos) {
+        return field;
+    }
+    std::string quoted = "\"";
+    for (char c : field) {
+        if (c == '"') {
+            quoted += '"';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+static std::vector<std::string> parse_csv_line(const std::string& line) {
+    std::vector<std::string> fields(1);
+    bool quoted = false;
+    for (size_t i = 0; i < line.size(); i++) {
+        char c = line[i];
+        if (quoted) {
+            if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+                fields.back() += c;
+                i++;
+            } else if (c == '"') {
+                quoted = false;
+            } else {
+                fields.back() += c;
+            }
+        } else if (c == '"') {
+            quoted = true;
+        } else if (c == ',') {
+            fields.emplace_back();
+        } else {
+            fields.back() += c;
+        }
+    }
+    return fields;
+}
+
+static std::string json_string(const std::string& value) {
+    std::string escaped = "\"";
+    for (char c : value) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped + "\"";
+}
+
+// the columns of the counters come last, so that CSVs from before they
+// were added can still be read as baselines
+#define CSV_HEADER_TIMES "family,rule,size,density,threads,generations," \
+    "repetitions,ns_per_cell,ns_per_cell_stddev,generations_per_second," \
+    "bandwidth_gb_per_second"
+#define CSV_HEADER CSV_HEADER_TIMES ",instructions_per_cycle," \
+    "l1_misses_per_cell,llc_misses_per_cell,branch_misses_per_cell"
+
+// counters that couldn't be read are empty in CSV, null in JSON and "n/a"
+// on the console
+static std::string format_counter(
+    const std::optional<double>& value, const char* missing
+) {
+    if (!value.has_value()) {
+        return missing;
+    }
+    std::ostringstream formatted;
+    formatted << *value;
+    return formatted.str();
+}
+
+static void write_csv(std::ostream& out, const std::vector<Result>& results) {
+    out << CSV_HEADER << endl;
+    for (const Result& result : results) {
+        out << csv_field(result.family) << "," << csv_field(result.rule) << ","
+            << result.size << "," << result.density << "," << result.threads
+            << "," << result.generations << "," << result.repetitions << ","
+            << result.ns_per_cell << "," << result.ns_per_cell_stddev << ","
+            << result.generations_per_second << ","
+            << result.bandwidth_gb_per_second << ","
+            << format_counter(result.instructions_per_cycle, "") << ","
+            << format_counter(result.l1_misses_per_cell, "") << ","
+            << format_counter(result.llc_misses_per_cell, "") << ","
+            << format_counter(result.branch_misses_per_cell, "") << endl;
+    }
+}
+
+static void write_json(std::ostream& out, const std::vector<Result>& results) {
+    out << "[" << endl;
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& result = results[i];
+        out << "  {\"family\": " << json_string(result.family)
+            << ", \"rule\": " << json_string(result.rule)
+            << ", \"size\": " << result.size
+            << ", \"density\": " << result.density
+            << ", \"threads\": " << result.threads
+            << ", \"generations\": " << result.generations
+            << ", \"repetitions\": " << result.repetitions
+            << ", \"ns_per_cell\": " << result.ns_per_cell
+            << ", \"ns_per_cell_stddev\": " << result.ns_per_cell_stddev
+            << ", \"generations_per_second\": "
+            << result.generations_per_second
+            << ", \"bandwidth_gb_per_second\": "
+            << result.bandwidth_gb_per_second
+            << ", \"instructions_per_cycle\": "
+            << format_counter(result.instructions_per_cycle, "null")
+            << ", \"l1_misses_per_cell\": "
+            << format_counter(result.l1_misses_per_cell, "null")
+            << ", \"llc_misses_per_cell\": "
+            << format_counter(result.llc_misses_per_cell, "null")
+            << ", \"branch_misses_per_cell\": "
+            << format_counter(result.branch_misses_per_cell, "null")
+            << "}" << (i + 1 < results.size() ? "," : "") << endl;
+    }
+    out << "]" << endl;
+}
+
+// ns/cell of every case in a CSV written by --csv
+static bool read_baseline(
+    const std::string& path, std::map<std::string, double>& baseline
+) {
+    std::ifstream file(path);
+    std::string line;
+    if (!std::getline(file, line) ||
+        (line != CSV_HEADER && line != CSV_HEADER_TIMES)) {
+        return false;
+    }
+    while (std::getline(file, line)) {
+        std::vector<std::string> fields = parse_csv_line(line);
+        if (fields.size() < 8) {
+            return false;
+        }
+        try {
+            baseline[case_key(
+                fields[0], fields[1], std::stoi(fields[2]),
+                std::stod(fields[3]), std::stoi(fields[4])
+            )] = std::stod(fields[7]);
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void print_counter(
+    const std::optional<double>& value, int width, int precision
+) {
+    char field[32];
+    if (value.has_value()) {
+        snprintf(field, sizeof(field), " %*.*f", width, precision, *value);
+    } else {
+        snprintf(field, sizeof(field), " %*s", width, "n/a");
+    }
+    cout << field;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    std::map<std::string, double> baseline;
+    if (!options.baseline_path.empty() &&
+        !read_baseline(options.baseline_path, baseline)) {
+        cerr << "can't read baseline " << options.baseline_path << endl;
+        return 1;
+    }
+
+    init_neighbourhood_offsets();
+
+    // the rule sets to run, by family and name
+    std::vector<std::pair<std::string, std::string>> rule_sets;
+    CellularAutomataMap cellular_automata = load_cellular_automata();
+    for (auto& family : cellular_automata) {
+        for (CellularAutomata* automata : family.second) {
+            if ((options.family.empty() || options.family == family.first) &&
+                (options.rule.empty() || options.rule == automata->name)) {
+                rule_sets.emplace_back(family.first, automata->name);
+            }
+            delete automata;
+        }
+    }
+    if (rule_sets.empty()) {
+        cerr << "no rule set matches (see tomato-headless --list)" << endl;
+        return 1;
+    }
+
+    std::vector<Result> results;
+    int regressions = 0;
+    char line[256];
+    snprintf(line, sizeof(line),
+             "%-40s %5s %7s %7s %10s %8s %10s %8s %6s %8s %8s %8s",
+             "rule set", "size", "density", "threads", "ns/cell", "+-",
+             "gens/s", "GB/s", "IPC", "L1/cell", "LLC/cell", "brm/cell");
+    cout << line << endl;
+
+    bool counters_noted = false;
+    for (int threads : options.threads) {
+        // opened before the rewriter starts its threads, so that the
+        // counters follow them too
+        PerfCounters counters;
+        if (!counters.any_available() && !counters_noted) {
+            cerr << "hardware counters unavailable ("
+                 << counters.get_error() << "), see"
+                 << " /proc/sys/kernel/perf_event_paranoid" << endl;
+            counters_noted = true;
+        }
+        ParallelRewriter rewriter(threads);
+        for (auto& rule_set : rule_sets) {
+            for (int size : options.sizes) {
+                for (double density : options.densities) {
+                    // fresh rule sets, so that no state (e.g. of turmites)
+                    // carries over from the previous case
+                    CellularAutomataMap fresh = load_cellular_automata();
+                    CellularAutomata* automata = find_cellular_automata(
+                        fresh, rule_set.first, rule_set.second
+                    );
+                    results.push_back(run_case(
+                        rule_set.first, *automata, size, density, rewriter,
+                        counters, options
+                    ));
+                    for (auto& family : fresh) {
+                        for (CellularAutomata* automata : family.second) {
+                            delete automata;
+                        }
+                    }
+
+                    const Result& result = results.back();
+                    std::string name = result.family + ": " + result.rule;
+                    snprintf(
+                        line, sizeof(line),
+                        "%-40s %5d %7.2f %7d %10.3f %8.3f %10.2f %8.3f",
+                        name.c_str(), size, density, threads,
+                        result.ns_per_cell, result.ns_per_cell_stddev,
+                        result.generations_per_second,
+                        result.bandwidth_gb_per_second
+                    );
+                    cout << line;
+                    print_counter(result.instructions_per_cycle, 6, 2);
+                    print_counter(result.l1_misses_per_cell, 8, 3);
+                    print_counter(result.llc_misses_per_cell, 8, 3);
+                    print_counter(result.branch_misses_per_cell, 8, 3);
+
+                    auto found = baseline.find(case_key(
+                        result.family, result.rule, size, density, threads
+                    ));
+                    if (found != baseline.end()) {
+                        double change =
+                            (result.ns_per_cell / found->second - 1) * 100;
+                        snprintf(line, sizeof(line), " %+.1f%%", change);
+                        cout << line;
+                        if (change > options.threshold) {
+                            cout << " REGRESSION";
+                            regressions++;
+                        }
+                    }
+                    cout << endl;
+                }
+            }
+        }
+    }
+
+    if (!options.csv_path.empty()) {
+        std::ofstream file(options.csv_path);
+        write_csv(file, results);
+    }
+    if (!options.json_path.empty()) {
+        std::ofstream file(options.json_path);
+        write_json(file, results);
+    }
+
+    if (regressions > 0) {
+        cout << regressions << " case(s) more than " << options.threshold
+             << "% slower than the baseline" << endl;
+        return 2;
+    }
+    return 0;
+}
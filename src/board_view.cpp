@@ -0,0 +1,388 @@
+#include <algorithm>
+#include <cmath>
+
+#include "board_view.h"
+#include "./common.h"
+#include "./phase_timer.h"
+
+// a tile needs its pixels recomputed from the states
+#define TILE_STALE 1
+// a tile needs to be uploaded to the texture
+#define TILE_UNUPLOADED 2
+
+// levels of detail are added until they get smaller than this
+#define LOD_MIN_SIZE 256
+// the grid is only drawn when cells are at least this many pixels wide
+#define GRID_MIN_CELL_SIZE 4
+// the most zoomed in view still shows this many cells
+#define MIN_VISIBLE_CELLS 4
+
+BoardView::BoardView(SDL_Renderer* renderer): renderer(renderer) {
+    palette.fill(0xff000000);
+
+    // cells are scaled up with nearest filtering so they keep sharp edges
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+}
+
+BoardView::~BoardView() {
+    free_textures();
+}
+
+void BoardView::free_textures() {
+    for (auto& level : levels) {
+        SDL_DestroyTexture(level.texture);
+    }
+    if (grid_texture != nullptr) {
+        SDL_DestroyTexture(grid_texture);
+        grid_texture = nullptr;
+    }
+}
+
+void BoardView::resize(int rows, int cols) {
+    free_textures();
+    levels.clear();
+    board_rows = rows;
+    board_cols = cols;
+
+    // level 0 has one texel per cell, every following level halves the
+    // size of the one before
+    int level_rows = rows;
+    int level_cols = cols;
+    do {
+        LodLevel level;
+        level.rows = level_rows;
+        level.cols = level_cols;
+        if (!levels.empty()) {
+            level.states.resize(level_rows * level_cols);
+        }
+        level.pixels.resize(level_rows * level_cols);
+        level.texture = SDL_CreateTexture(
+            renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+            level_cols, level_rows
+        );
+        level.tile_rows = (level_rows + TILE_SIZE - 1) / TILE_SIZE;
+        level.tile_cols = (level_cols + TILE_SIZE - 1) / TILE_SIZE;
+        level.tile_flags.assign(
+            level.tile_rows * level.tile_cols, TILE_STALE | TILE_UNUPLOADED
+        );
+        levels.push_back(std::move(level));
+
+        level_rows = (level_rows + 1) / 2;
+        level_cols = (level_cols + 1) / 2;
+    } while (std::max(level_rows, level_cols) >= LOD_MIN_SIZE);
+
+    DirtyRect whole_board { 0, 0, rows-1, cols-1 };
+    changed_cells = whole_board;
+    stale_pixels = whole_board;
+
+    reset_viewport();
+}
+
+void BoardView::set_palette(const std::array<uint32_t, 256>& palette) {
+    this->palette = palette;
+    for (auto& level : levels) {
+        std::fill(
+            level.tile_flags.begin(), level.tile_flags.end(),
+            TILE_STALE | TILE_UNUPLOADED
+        );
+    }
+}
+
+void BoardView::mark_changed(const DirtyRect& rect) {
+    changed_cells.include(rect);
+    stale_pixels.include(rect);
+}
+
+void BoardView::mark_colorized(const DirtyRect& rect, bool all_pixels_written) {
+    changed_cells.include(rect);
+    if (all_pixels_written) {
+        stale_pixels = DirtyRect();
+        for (auto& flags : levels[0].tile_flags) {
+            flags &= ~TILE_STALE;
+        }
+    }
+}
+
+void BoardView::mark_tiles(
+    LodLevel& level, const DirtyRect& rect, uint8_t flags
+) {
+    if (rect.empty()) {
+        return;
+    }
+
+    for (int tile_row = rect.min_row / TILE_SIZE;
+         tile_row <= rect.max_row / TILE_SIZE; tile_row++
+    ) {
+        for (int tile_col = rect.min_col / TILE_SIZE;
+             tile_col <= rect.max_col / TILE_SIZE; tile_col++
+        ) {
+            level.tile_flags[tile_row * level.tile_cols + tile_col] |= flags;
+        }
+    }
+}
+
+// brings the states of every level up to date with the cells changed since
+// the last draw, and marks the affected tiles
+void BoardView::update_levels(const Board& board) {
+    mark_tiles(levels[0], changed_cells, TILE_UNUPLOADED);
+    mark_tiles(levels[0], stale_pixels, TILE_STALE | TILE_UNUPLOADED);
+
+    DirtyRect rect = changed_cells;
+    for (size_t i = 1; i < levels.size() && !rect.empty(); i++) {
+        const LodLevel& previous = levels[i-1];
+        LodLevel& level = levels[i];
+        rect = { rect.min_row / 2, rect.min_col / 2,
+                 rect.max_row / 2, rect.max_col / 2 };
+
+        auto get_previous = [&](int row, int col) {
+            return i == 1 ?
+                board[row][col] : previous.states[row * previous.cols + col];
+        };
+
+        for (int row = rect.min_row; row <= rect.max_row; row++) {
+            int top = row * 2;
+            int bottom = std::min(top + 1, previous.rows - 1);
+            for (int col = rect.min_col; col <= rect.max_col; col++) {
+                int left = col * 2;
+                int right = std::min(left + 1, previous.cols - 1);
+                level.states[row * level.cols + col] = std::max({
+                    get_previous(top, left), get_previous(top, right),
+                    get_previous(bottom, left), get_previous(bottom, right)
+                });
+            }
+        }
+
+        mark_tiles(level, rect, TILE_STALE | TILE_UNUPLOADED);
+    }
+
+    changed_cells = DirtyRect();
+    stale_pixels = DirtyRect();
+}
+
+// converts and uploads the flagged tiles overlapping the given range of a
+// level, merging horizontally adjacent tiles into a single upload
+void BoardView::upload_visible_tiles(
+    const Board& board, size_t level_index,
+    int first_row, int first_col, int last_row, int last_col
+) {
+    LodLevel& level = levels[level_index];
+    const uint8_t* states =
+        level_index == 0 ? board.cells.data() : level.states.data();
+
+    int first_tile_col = first_col / TILE_SIZE;
+    int last_tile_col = last_col / TILE_SIZE;
+
+    for (int tile_row = first_row / TILE_SIZE;
+         tile_row <= last_row / TILE_SIZE; tile_row++
+    ) {
+        int row_begin = tile_row * TILE_SIZE;
+        int row_end = std::min(row_begin + TILE_SIZE, level.rows);
+        uint8_t* flags = &level.tile_flags[tile_row * level.tile_cols];
+
+        int tile_col = first_tile_col;
+        while (tile_col <= last_tile_col) {
+            if (flags[tile_col] == 0) {
+                tile_col++;
+                continue;
+            }
+
+            int run_begin = tile_col;
+            while (tile_col <= last_tile_col && flags[tile_col] != 0) {
+                if (flags[tile_col] & TILE_STALE) {
+                    int col_begin = tile_col * TILE_SIZE;
+                    int col_end = std::min(col_begin + TILE_SIZE, level.cols);
+                    for (int row = row_begin; row < row_end; row++) {
+                        const uint8_t* state_row = &states[row * level.cols];
+                        uint32_t* pixel_row = &level.pixels[row * level.cols];
+                        for (int col = col_begin; col < col_end; col++) {
+                            pixel_row[col] = palette[state_row[col]];
+                        }
+                    }
+                }
+                flags[tile_col] = 0;
+                tile_col++;
+            }
+
+            int col_begin = run_begin * TILE_SIZE;
+            int col_end = std::min(tile_col * TILE_SIZE, level.cols);
+            SDL_Rect rect {
+                col_begin, row_begin, col_end - col_begin, row_end - row_begin
+            };
+            SDL_UpdateTexture(
+                level.texture, &rect,
+                &level.pixels[row_begin * level.cols + col_begin],
+                level.cols * sizeof(uint32_t)
+            );
+        }
+    }
+}
+
+void BoardView::draw(
+    const Board& board, int width, int height, bool grid_enabled
+) {
+    if (board.rows != board_rows || board.cols != board_cols) {
+        resize(board.rows, board.cols);
+    }
+
+    {
+        PhaseTimer timer("levels");
+        update_levels(board);
+    }
+
+    // use the most detailed level that still has at most one texel per
+    // window pixel
+    double cells_per_pixel = std::max(
+        visible_cols() / width, visible_rows() / height
+    );
+    size_t level_index = 0;
+    while (level_index + 1 < levels.size()
+           && cells_per_pixel >= (1 << (level_index + 1))
+    ) {
+        level_index++;
+    }
+    const LodLevel& level = levels[level_index];
+
+    // the visible part of the level, in texels
+    double scale = 1 << level_index;
+    double level_row = view_row / scale;
+    double level_col = view_col / scale;
+    double level_rows = visible_rows() / scale;
+    double level_cols = visible_cols() / scale;
+
+    int first_row = std::floor(level_row);
+    int first_col = std::floor(level_col);
+    int end_row = std::min(
+        static_cast<int>(std::ceil(level_row + level_rows)), level.rows
+    );
+    int end_col = std::min(
+        static_cast<int>(std::ceil(level_col + level_cols)), level.cols
+    );
+
+    {
+        PhaseTimer timer("upload");
+        upload_visible_tiles(
+            board, level_index, first_row, first_col, end_row - 1, end_col - 1
+        );
+    }
+
+    double texel_width = width / level_cols;
+    double texel_height = height / level_rows;
+    int left = std::lround((first_col - level_col) * texel_width);
+    int top = std::lround((first_row - level_row) * texel_height);
+    int right = std::lround((end_col - level_col) * texel_width);
+    int bottom = std::lround((end_row - level_row) * texel_height);
+
+    SDL_Rect src {
+        first_col, first_row, end_col - first_col, end_row - first_row
+    };
+    SDL_Rect dest { left, top, right - left, bottom - top };
+    SDL_RenderCopy(renderer, level.texture, &src, &dest);
+
+    if (grid_enabled && level_index == 0
+        && texel_width >= GRID_MIN_CELL_SIZE
+        && texel_height >= GRID_MIN_CELL_SIZE
+    ) {
+        if (grid_texture == nullptr
+            || grid_width != width || grid_height != height
+            || grid_zoom != zoom || grid_row != view_row
+            || grid_col != view_col
+        ) {
+            update_grid_texture(width, height);
+        }
+        SDL_Rect window_rect { 0, 0, width, height };
+        SDL_RenderCopy(renderer, grid_texture, nullptr, &window_rect);
+    }
+}
+
+// draws the grid lines once into a transparent texture that is laid over
+// the board, rebuilt only when the window size or the viewport changes
+void BoardView::update_grid_texture(int width, int height) {
+    if (grid_texture == nullptr || grid_width != width
+        || grid_height != height
+    ) {
+        if (grid_texture != nullptr) {
+            SDL_DestroyTexture(grid_texture);
+        }
+        grid_texture = SDL_CreateTexture(
+            renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET,
+            width, height
+        );
+        SDL_SetTextureBlendMode(grid_texture, SDL_BLENDMODE_BLEND);
+    }
+    grid_width = width;
+    grid_height = height;
+    grid_zoom = zoom;
+    grid_row = view_row;
+    grid_col = view_col;
+
+    SDL_Texture* old_target = SDL_GetRenderTarget(renderer);
+    SDL_SetRenderTarget(renderer, grid_texture);
+    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+    SDL_RenderClear(renderer);
+
+    double cell_width = width / visible_cols();
+    double cell_height = height / visible_rows();
+
+    SDL_SetRenderDrawColor(renderer, 70, 70, 70, 255);
+    // draw vertical grid lines
+    for (int col = std::ceil(view_col); col < view_col + visible_cols(); col++) {
+        int x = std::lround((col - view_col) * cell_width);
+        if (x > 0) {
+            SDL_RenderDrawLine(renderer, x, 0, x, height);
+        }
+    }
+
+    // draw horizontal grid lines
+    for (int row = std::ceil(view_row); row < view_row + visible_rows(); row++) {
+        int y = std::lround((row - view_row) * cell_height);
+        if (y > 0) {
+            SDL_RenderDrawLine(renderer, 0, y, width, y);
+        }
+    }
+
+    SDL_SetRenderTarget(renderer, old_target);
+}
+
+void BoardView::clamp_viewport() {
+    double max_zoom = std::max(
+        1.0, static_cast<double>(std::min(board_rows, board_cols))
+            / MIN_VISIBLE_CELLS
+    );
+    zoom = std::clamp(zoom, 1.0, max_zoom);
+    view_row = std::clamp(view_row, 0.0, board_rows - visible_rows());
+    view_col = std::clamp(view_col, 0.0, board_cols - visible_cols());
+}
+
+void BoardView::zoom_at(
+    double factor, double x, double y, int width, int height
+) {
+    double row = view_row + y / height * visible_rows();
+    double col = view_col + x / width * visible_cols();
+
+    zoom *= factor;
+    clamp_viewport();
+
+    view_row = row - y / height * visible_rows();
+    view_col = col - x / width * visible_cols();
+    clamp_viewport();
+}
+
+void BoardView::pan(double dx, double dy, int width, int height) {
+    view_row -= dy / height * visible_rows();
+    view_col -= dx / width * visible_cols();
+    clamp_viewport();
+}
+
+void BoardView::reset_viewport() {
+    zoom = 1;
+    view_row = 0;
+    view_col = 0;
+}
+
+bool BoardView::window_to_cell(
+    double x, double y, int width, int height, int& row, int& col
+) const {
+    row = std::floor(view_row + y / height * visible_rows());
+    col = std::floor(view_col + x / width * visible_cols());
+    return row >= 0 && row < board_rows && col >= 0 && col < board_cols;
+}
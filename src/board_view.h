@@ -0,0 +1,110 @@
+#ifndef BOARD_VIEW_H
+#define BOARD_VIEW_H
+
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <array>
+#include <vector>
+
+#include "./common.h"
+
+// the textures are updated in square tiles of this many texels, so that
+// only visible tiles have to be uploaded
+#define TILE_SIZE 64
+
+// Draws the board into the window through a zoomable, pannable viewport.
+//
+// The board is kept in a streaming texture that is updated incrementally
+// from the cells reported as changed. When zoomed out far enough that
+// several cells fall on one window pixel, a downsampled level of detail is
+// drawn instead: level n has one texel per 2^n x 2^n block of cells, holding
+// the highest state in the block. The levels are updated only where cells
+// changed, and only tiles that are visible are ever converted to pixels and
+// uploaded, so the cost of a frame is bounded by the window size rather
+// than the board size.
+class BoardView {
+    private:
+        struct LodLevel {
+            int rows;
+            int cols;
+            // states of the level; empty for level 0, which is the board
+            std::vector<uint8_t> states;
+            std::vector<uint32_t> pixels;
+            SDL_Texture* texture = nullptr;
+
+            int tile_rows;
+            int tile_cols;
+            // TILE_* flags, one per tile
+            std::vector<uint8_t> tile_flags;
+        };
+
+        SDL_Renderer* renderer;
+        std::array<uint32_t, 256> palette;
+        std::vector<LodLevel> levels;
+
+        // cells changed since the last draw, and the subset of them whose
+        // pixels have not been written by a fused rewrite
+        DirtyRect changed_cells;
+        DirtyRect stale_pixels;
+
+        // viewport, as the top left corner of the window and the number of
+        // rows/cols visible, all in board cells
+        int board_rows = 0;
+        int board_cols = 0;
+        double zoom = 1;
+        double view_row = 0;
+        double view_col = 0;
+
+        SDL_Texture* grid_texture = nullptr;
+        int grid_width = 0;
+        int grid_height = 0;
+        double grid_zoom = 0;
+        double grid_row = -1;
+        double grid_col = -1;
+
+        void free_textures();
+        void clamp_viewport();
+        double visible_rows() const { return board_rows / zoom; }
+        double visible_cols() const { return board_cols / zoom; }
+        void mark_tiles(LodLevel& level, const DirtyRect& rect, uint8_t flags);
+        void update_levels(const Board& board);
+        void upload_visible_tiles(
+            const Board& board, size_t level_index,
+            int first_row, int first_col, int last_row, int last_col
+        );
+        void update_grid_texture(int width, int height);
+
+    public:
+        BoardView(SDL_Renderer* renderer);
+        ~BoardView();
+
+        // (re)creates the textures and the level of detail pyramid
+        void resize(int rows, int cols);
+        int rows() const { return board_rows; }
+        int cols() const { return board_cols; }
+        // pixels of level 0, which fused rewrites' pixels are swapped into
+        std::vector<uint32_t>& pixel_buffer() { return levels[0].pixels; }
+        void set_palette(const std::array<uint32_t, 256>& palette);
+
+        // cells in 'rect' changed and their pixels need to be recomputed
+        void mark_changed(const DirtyRect& rect);
+        // cells in 'rect' were changed by a fused rewrite that already wrote
+        // their pixels. If 'all_pixels_written' is set, every pixel of the
+        // board was written.
+        void mark_colorized(const DirtyRect& rect, bool all_pixels_written);
+
+        void draw(const Board& board, int width, int height, bool grid_enabled);
+
+        // zooms by 'factor' keeping the cell under window position (x, y)
+        // in place
+        void zoom_at(double factor, double x, double y, int width, int height);
+        // moves the view by (dx, dy) window pixels
+        void pan(double dx, double dy, int width, int height);
+        void reset_viewport();
+        // gets the cell under window position (x, y)
+        bool window_to_cell(
+            double x, double y, int width, int height, int& row, int& col
+        ) const;
+};
+
+#endif
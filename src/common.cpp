@@ -1,15 +1,11 @@
 #include <string>
 #include <sstream>
 #include <iostream>
+#include <stdexcept>
 
 #include "./common.h"
-#include "imgui.h"
 #include "./automata/automata.h"
 
-// set the range limit for generating offsets
-// currently, no rulesets require greater than 10 range
-#define MAX_NEIGHBOURHOOD_RANGE 10
-
 // globals
 std::vector<std::vector<std::vector<int8_t>>> moore_offsets;
 std::vector<std::vector<std::vector<int8_t>>> von_neumann_offsets;
@@ -35,6 +31,44 @@ void init_neighbourhood_offsets() {
     };
 }
 
+void count_cells(const Board& board, const Board& next, StepStats& stats) {
+    for (int row = 0; row < board.rows; row++) {
+        int first_live = -1;
+        int last_live = -1;
+        for (int col = 0; col < board.cols; col++) {
+            uint8_t old_state = board[row][col];
+            uint8_t state = next[row][col];
+            stats.population[state]++;
+            if (state != 0) {
+                if (first_live == -1) {
+                    first_live = col;
+                }
+                last_live = col;
+            }
+            stats.births += old_state == 0 && state != 0;
+            stats.deaths += old_state != 0 && state == 0;
+        }
+        if (first_live != -1) {
+            stats.live.include_span(row, first_live, last_live);
+        }
+    }
+}
+
+uint64_t board_checksum(const Board& board) {
+    uint64_t hash = 0xcbf29ce484222325;
+    auto add = [&hash](uint8_t byte) {
+        hash = (hash ^ byte) * 0x100000001b3;
+    };
+    for (int i = 0; i < 4; i++) {
+        add(board.rows >> (i * 8));
+        add(board.cols >> (i * 8));
+    }
+    for (uint8_t cell : board.cells) {
+        add(cell);
+    }
+    return hash;
+}
+
 std::vector<std::string> split(const std::string& s, char delimiter)
 {
    std::vector<std::string> tokens;
@@ -106,7 +140,7 @@ generate_all_neighbourhood_offsets(
     // initalize offsets to {} because there is no valid offsets[0]
     std::vector<std::vector<std::vector<int8_t>>> offsets {{}};
 
-    for (int range = 1; range < MAX_NEIGHBOURHOOD_RANGE; range++) {
+    for (int range = 1; range <= MAX_NEIGHBOURHOOD_RANGE; range++) {
         offsets.push_back(generate_neighbourhood_offsets(
             neighbourhood_type, range
         ));
@@ -137,8 +171,8 @@ int _get_neighbour_count(
         auto row_offset = offset[0];
         auto col_offset = offset[1];
 
-        int neighbour_row = modulo(row + row_offset, BOARD_ROWS);
-        int neighbour_col = modulo(col + col_offset, BOARD_COLS);
+        int neighbour_row = modulo(row + row_offset, board.rows);
+        int neighbour_col = modulo(col + col_offset, board.cols);
 
         if ((bitmask != -1 && (bitmask & board[neighbour_row][neighbour_col]) == 1)
             || contains(firing_states, board[neighbour_row][neighbour_col])
@@ -158,11 +192,13 @@ int get_weighted_neighbour_count(
     for (auto& pair : weights) {
         auto direction = pair.first;
 
-        auto offsets = direction_to_offset[direction];
+        // at() rather than [], which may insert, so that boards can be
+        // rewritten from several threads
+        auto offsets = direction_to_offset.at(direction);
         int row_offset = offsets[0];
         int col_offset = offsets[1];
-        int neighbour_row = modulo(row + row_offset, BOARD_ROWS);
-        int neighbour_col = modulo(col + col_offset, BOARD_COLS);
+        int neighbour_row = modulo(row + row_offset, board.rows);
+        int neighbour_col = modulo(col + col_offset, board.cols);
         if (board[neighbour_row][neighbour_col] == 1) {
             neighbour_count += weights[direction];
         }
@@ -187,6 +223,35 @@ int get_extended_neighbour_count(
     return _get_neighbour_count(board, offsets, row, col, firing_states);
 }
 
+int neighbourhood_size(NeighbourhoodType neighbourhood_type, int range) {
+    switch (neighbourhood_type) {
+        case NeighbourhoodType::Moore:
+            return (2 * range + 1) * (2 * range + 1) - 1;
+        case NeighbourhoodType::VonNeumann:
+            return 2 * range * (range + 1);
+    }
+
+    return 0;
+}
+
+void check_neighbourhood_range(const std::string& family, int range) {
+    if (range < 1 || range > MAX_NEIGHBOURHOOD_RANGE) {
+        throw new std::runtime_error(
+            family + " neighbourhood range must be in [1.." +
+            std::to_string(MAX_NEIGHBOURHOOD_RANGE) + "]"
+        );
+    }
+}
+
+uint8_t check_num_states(const std::string& family, int num_states) {
+    if (num_states < 2 || num_states > 255) {
+        throw new std::runtime_error(
+            family + " state count must be in [2..255]"
+        );
+    }
+    return num_states;
+}
+
 // gets the values of all neighbours in VonNeumann neighbourhood with range 1
 // in the order [SELF, NORTH, EAST, SOUTH, WEST]
 std::vector<uint8_t> get_neighbour_configuration(
@@ -203,8 +268,8 @@ std::vector<uint8_t> get_neighbour_configuration(
     for (auto& offset : offsets) {
         int row_offset = offset[0];
         int col_offset = offset[1];
-        int neighbour_row = modulo(row + row_offset, BOARD_ROWS);
-        int neighbour_col = modulo(col + col_offset, BOARD_COLS);
+        int neighbour_row = modulo(row + row_offset, board.rows);
+        int neighbour_col = modulo(col + col_offset, board.cols);
         neighbour_values.push_back(board[neighbour_row][neighbour_col]);
     }
 
@@ -8,9 +8,12 @@
 #include <algorithm>
 #include <optional>
 #include <cstdint>
+#include <climits>
 
-#define BOARD_ROWS 100
-#define BOARD_COLS 100
+#define DEFAULT_BOARD_SIZE 100
+// set the range limit for generating offsets
+// currently, no rulesets require greater than 10 range
+#define MAX_NEIGHBOURHOOD_RANGE 10
 
 //
 // forward declarations
@@ -30,16 +33,130 @@ extern std::map<std::string, std::vector<int>> direction_to_offset;
 //
 // typedefs
 //
-typedef std::array<std::array<uint8_t, BOARD_COLS>, BOARD_ROWS> Board;
 typedef std::array<uint8_t, 3> Color;
 typedef std::map<std::string, std::vector<CellularAutomata*>>
         CellularAutomataMap;
 typedef std::vector<std::array<uint8_t, 3>> ColorPalette;
 
+//
+// structs
+//
+
+// A grid of cell states stored row-major in a single block, indexed as
+// board[row][col]. The edges wrap around.
+struct Board {
+    int rows;
+    int cols;
+    std::vector<uint8_t> cells;
+
+    Board(): Board(DEFAULT_BOARD_SIZE, DEFAULT_BOARD_SIZE) {}
+    Board(int rows, int cols)
+        : rows(rows), cols(cols), cells(size_t(rows) * cols) {}
+
+    uint8_t* operator[](int row) { return &cells[row * cols]; }
+    const uint8_t* operator[](int row) const { return &cells[row * cols]; }
+
+    void fill(uint8_t state) { std::fill(cells.begin(), cells.end(), state); }
+    bool in_bounds(int row, int col) const {
+        return row >= 0 && row < rows && col >= 0 && col < cols;
+    }
+};
+
+// Inclusive bounding box of a set of cells. Rewrites report the cells they
+// changed this way so that the renderer only needs to re-upload that part
+// of the board.
+struct DirtyRect {
+    int min_row = INT_MAX;
+    int min_col = INT_MAX;
+    int max_row = -1;
+    int max_col = -1;
+
+    bool empty() const { return max_row < min_row; }
+
+    void include(int row, int col) {
+        include_span(row, col, col);
+    }
+
+    void include_span(int row, int first_col, int last_col) {
+        min_row = std::min(min_row, row);
+        max_row = std::max(max_row, row);
+        min_col = std::min(min_col, first_col);
+        max_col = std::max(max_col, last_col);
+    }
+
+    void include(const DirtyRect& other) {
+        if (!other.empty()) {
+            min_row = std::min(min_row, other.min_row);
+            max_row = std::max(max_row, other.max_row);
+            min_col = std::min(min_col, other.min_col);
+            max_col = std::max(max_col, other.max_col);
+        }
+    }
+
+    static DirtyRect whole_board(const Board& board) {
+        return { 0, 0, board.rows-1, board.cols-1 };
+    }
+};
+
+// Counts gathered while rewriting a board, describing the new board.
+// Rewrites add to them, so a generation computed in several parts (bands of
+// rows, or rows spread over several frames) adds up to the whole board.
+struct StepStats {
+    // cells in each state
+    std::array<uint32_t, 256> population {};
+    // cells that went from state 0 to another state, and the other way
+    uint32_t births = 0;
+    uint32_t deaths = 0;
+    // bounding box of the cells in a state other than 0
+    DirtyRect live;
+
+    void add(const StepStats& other) {
+        for (size_t i = 0; i < population.size(); i++) {
+            population[i] += other.population[i];
+        }
+        births += other.births;
+        deaths += other.deaths;
+        live.include(other.live);
+    }
+};
+
+// Per-generation state shared between a rewrite and its caller.
+struct StepContext {
+    // Optional fused colorizing. When 'pixels' is set, the rewrite also
+    // writes palette[state] into pixels[row * board.cols + col] for every
+    // cell it writes, which saves a second pass over the board when the
+    // generation is going to be displayed.
+    const uint32_t* palette = nullptr;
+    uint32_t* pixels = nullptr;
+
+    // cells whose state differs between the old and the new board
+    DirtyRect dirty;
+    // set when the rewrite wrote a pixel for every cell it rewrote (all of
+    // the board, or all of the rows it was given) rather than only for the
+    // cells it changed
+    bool pixels_complete = false;
+
+    // optional statistics of the new board, gathered as the cells are
+    // written
+    StepStats* stats = nullptr;
+
+    bool change_made() const { return !dirty.empty(); }
+};
+
 //
 // functions
 //
 CellularAutomataMap load_cellular_automata();
+// gets a rule set of load_cellular_automata() by name, or nullptr
+CellularAutomata* find_cellular_automata(
+    const CellularAutomataMap& cellular_automata,
+    const std::string& family, const std::string& name
+);
+// adds the statistics of the generation from 'board' to 'next' to 'stats',
+// for rewrites that don't go through rewrite_cells()
+void count_cells(const Board& board, const Board& next, StepStats& stats);
+// FNV-1a hash of the board size and cells, for comparing boards across runs
+uint64_t board_checksum(const Board& board);
 std::vector<std::string> split(const std::string& s, char delimiter);
 template<typename T>
 bool contains(const std::vector<T>& vec, T val) {
@@ -72,12 +189,16 @@ int get_extended_neighbour_count(
 std::vector<uint8_t> get_neighbour_configuration(
     const Board& board, int row, int col
 );
+// cells in the neighbourhood of 'range', not counting the center cell
+int neighbourhood_size(NeighbourhoodType neighbourhood_type, int range);
 
-// inline functions
-inline int in_bounds(int row, int col) {
-    return row >= 9 && row < BOARD_ROWS && col >= 0 && col < BOARD_COLS;
-}
+// Checks shared by the rule set constructors, which throw a
+// std::runtime_error* naming 'family' when the value is out of range.
+void check_neighbourhood_range(const std::string& family, int range);
+// a state count must be within [2..255]; returns it as a state
+uint8_t check_num_states(const std::string& family, int num_states);
 
+// inline functions
 inline int modulo(int a, int b) {
     return ((a % b) + b) % b;
 }
@@ -113,11 +234,118 @@ public:
 
     // methods
     virtual ~CellularAutomata() {}
-    virtual std::pair<Board, bool> rewrite(const Board& board) = 0;
+    // Writes the generation following 'board' into 'board_copy'. Every cell
+    // of 'board_copy' is overwritten, so it may hold any old board.
+    virtual void rewrite(
+        const Board& board, Board& board_copy, StepContext& context
+    ) {
+        rewrite_rows(board, board_copy, context, 0, board.rows);
+    }
+    // Writes rows [first_row, last_row) of the generation following 'board'
+    // into 'board_copy'. A generation may be computed in several calls
+    // (e.g. spread over several frames) as long as every row is written
+    // once and 'board' doesn't change in between.
+    virtual void rewrite_rows(
+        const Board& board, Board& board_copy, StepContext& context,
+        int first_row, int last_row
+    ) = 0;
+    // whether rewrite_rows() accepts ranges smaller than the whole board
+    virtual bool can_rewrite_rows() const { return true; }
+    // Hash of whatever the rule set keeps besides the board, which has to
+    // repeat along with the board for the board to cycle. 0 if nothing.
+    virtual uint64_t state_hash() const { return 0; }
+    // whether handle_mouse_click() changes more than the cells (e.g. adds
+    // an ant), so that a click still matters after the board is cleared
+    virtual bool click_changes_state() const { return false; }
 
     virtual void handle_mouse_click(
         Board& board, int selected_state, int row, int col, bool is_right_click
     );
 };
 
+// Rewrites row 'row' of 'board_copy' as rewrite_cells() does, counting
+// into 'stats' when COUNT is set.
+template<bool COUNT, typename F>
+void rewrite_cells_row(
+    const Board& board, Board& board_copy, StepContext& context, int row,
+    F& next_state, StepStats* stats
+) {
+    const uint32_t* palette = context.palette;
+    int first_changed = -1;
+    int last_changed = -1;
+    int first_live = -1;
+    int last_live = -1;
+    uint32_t births = 0;
+    uint32_t deaths = 0;
+    uint32_t* pixel_row = context.pixels != nullptr ?
+        &context.pixels[row * board.cols] : nullptr;
+
+    for (int col = 0; col < board.cols; col++) {
+        uint8_t state = next_state(row, col);
+        uint8_t old_state = board[row][col];
+        board_copy[row][col] = state;
+        if (pixel_row != nullptr) {
+            pixel_row[col] = palette[state];
+        }
+
+        if (state != old_state) {
+            if (first_changed == -1) {
+                first_changed = col;
+            }
+            last_changed = col;
+        }
+        if (COUNT) {
+            stats->population[state]++;
+            if (state != 0) {
+                if (first_live == -1) {
+                    first_live = col;
+                }
+                last_live = col;
+            }
+            births += old_state == 0 && state != 0;
+            deaths += old_state != 0 && state == 0;
+        }
+    }
+
+    if (first_changed != -1) {
+        context.dirty.include_span(row, first_changed, last_changed);
+    }
+    if (COUNT) {
+        if (first_live != -1) {
+            stats->live.include_span(row, first_live, last_live);
+        }
+        stats->births += births;
+        stats->deaths += deaths;
+    }
+}
+
+// Rewrites every cell of rows [first_row, last_row) with
+// next_state(row, col), which must only read from 'board', records the
+// changed cells in 'context' and colorizes them and gathers statistics if
+// the context asks for it.
+template<typename F>
+void rewrite_cells(
+    const Board& board, Board& board_copy, StepContext& context,
+    int first_row, int last_row, F next_state
+) {
+    if (context.stats == nullptr) {
+        for (int row = first_row; row < last_row; row++) {
+            rewrite_cells_row<false>(
+                board, board_copy, context, row, next_state, nullptr
+            );
+        }
+    } else {
+        // counted locally, and added to the context once
+        StepStats stats;
+        for (int row = first_row; row < last_row; row++) {
+            rewrite_cells_row<true>(
+                board, board_copy, context, row, next_state, &stats
+            );
+        }
+        context.stats->add(stats);
+    }
+
+    context.pixels_complete = context.pixels != nullptr;
+}
+
 #endif
@@ -0,0 +1,239 @@
+#include <cstring>
+
+#include "./cycle_detector.h"
+
+// the polynomial hash is computed modulo this (Mersenne) prime
+static const uint64_t MODULUS = (uint64_t(1) << 61) - 1;
+static const uint64_t NO_GENERATION = UINT64_MAX;
+
+// splitmix64's finalizer, turning consecutive numbers into random keys
+static uint64_t mix(uint64_t x) {
+    x += 0x9e3779b97f4a7c15;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
+static uint64_t add_mod(uint64_t a, uint64_t b) {
+    uint64_t sum = a + b;
+    return sum >= MODULUS ? sum - MODULUS : sum;
+}
+
+static uint64_t sub_mod(uint64_t a, uint64_t b) {
+    return a >= b ? a - b : a + MODULUS - b;
+}
+
+static uint64_t mul_mod(uint64_t a, uint64_t b) {
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    uint64_t sum = (static_cast<uint64_t>(product) & MODULUS)
+        + static_cast<uint64_t>(product >> 61);
+    return sum >= MODULUS ? sum - MODULUS : sum;
+}
+
+static uint64_t pow_mod(uint64_t base, uint64_t exponent) {
+    uint64_t result = 1;
+    while (exponent > 0) {
+        if (exponent & 1) {
+            result = mul_mod(result, base);
+        }
+        base = mul_mod(base, base);
+        exponent >>= 1;
+    }
+    return result;
+}
+
+// the bases of the polynomial hash for rows and columns
+static const uint64_t ROW_BASE = mix(1) % (MODULUS - 2) + 2;
+static const uint64_t COL_BASE = mix(2) % (MODULUS - 2) + 2;
+
+static uint64_t zobrist_key(int index, uint8_t state) {
+    return mix((static_cast<uint64_t>(index) << 8) | state);
+}
+
+static uint64_t state_weight(uint8_t state) {
+    return mix(~static_cast<uint64_t>(state)) % (MODULUS - 1) + 1;
+}
+
+static void fill_powers(
+    std::vector<uint64_t>& powers, std::vector<uint64_t>& inverse_powers,
+    uint64_t base, int count
+) {
+    uint64_t inverse = pow_mod(base, MODULUS - 2);
+    powers.assign(count, 1);
+    inverse_powers.assign(count, 1);
+    for (int i = 1; i < count; i++) {
+        powers[i] = mul_mod(powers[i-1], base);
+        inverse_powers[i] = mul_mod(inverse_powers[i-1], inverse);
+    }
+}
+
+void CycleDetector::add_cell(int row, int col, uint8_t state, int sign) {
+    if (state == 0) {
+        return;
+    }
+    hash.zobrist ^= zobrist_key(row * cols + col, state);
+    uint64_t term = mul_mod(
+        state_weight(state), mul_mod(row_powers[row], col_powers[col])
+    );
+    if (sign > 0) {
+        hash.polynomial = add_mod(hash.polynomial, term);
+    } else {
+        hash.polynomial = sub_mod(hash.polynomial, term);
+    }
+    hash.population += sign;
+    hash.row_sum += sign * row;
+    hash.col_sum += sign * col;
+}
+
+void CycleDetector::apply_changes(
+    const Board& old_board, const Board& board, const DirtyRect& changed
+) {
+    if (changed.empty()) {
+        return;
+    }
+    int width = changed.max_col - changed.min_col + 1;
+    for (int row = changed.min_row; row <= changed.max_row; row++) {
+        const uint8_t* old_cells = old_board[row] + changed.min_col;
+        const uint8_t* cells = board[row] + changed.min_col;
+        if (memcmp(old_cells, cells, width) == 0) {
+            continue;
+        }
+        for (int i = 0; i < width; i++) {
+            if (old_cells[i] != cells[i]) {
+                add_cell(row, changed.min_col + i, old_cells[i], -1);
+                add_cell(row, changed.min_col + i, cells[i], 1);
+            }
+        }
+    }
+}
+
+void CycleDetector::remember(uint64_t generation, uint64_t state_hash) {
+    Entry& entry = history[generation % CYCLE_HISTORY];
+    entry.generation = generation;
+    entry.key = hash.zobrist ^ state_hash;
+    entry.hash = hash;
+    table[entry.key % CYCLE_TABLE_SIZE] = generation;
+    last_generation = generation;
+}
+
+const CycleDetector::Entry* CycleDetector::find(uint64_t generation) const {
+    if (generation < first_generation || generation > last_generation ||
+        last_generation - generation >= CYCLE_HISTORY) {
+        return nullptr;
+    }
+    const Entry& entry = history[generation % CYCLE_HISTORY];
+    return entry.generation == generation ? &entry : nullptr;
+}
+
+// looks the board up in the table, which only keeps the newest generation
+// per slot: a repeat whose slot was taken since is found a period later
+bool CycleDetector::find_exact(uint64_t key, uint64_t generation) {
+    const Entry* entry = find(table[key % CYCLE_TABLE_SIZE]);
+    if (entry == nullptr || entry->key != key ||
+        entry->hash.polynomial != hash.polynomial ||
+        entry->hash.population != hash.population) {
+        return false;
+    }
+    cycle.period = generation - entry->generation;
+    cycle.row_shift = 0;
+    cycle.col_shift = 0;
+    cycle.generation = generation;
+    return true;
+}
+
+// compares the board with each recent generation shifted by the
+// difference in centroids, when that is a whole number of cells
+bool CycleDetector::find_translation(uint64_t generation) {
+    if (hash.population == 0) {
+        return false;
+    }
+    for (int period = 1; period <= MAX_TRANSLATION_PERIOD &&
+         static_cast<uint64_t>(period) <= generation; period++) {
+        const Entry* entry = find(generation - period);
+        if (entry == nullptr) {
+            break;
+        }
+        if (entry->hash.population != hash.population) {
+            continue;
+        }
+        int64_t row_difference = hash.row_sum - entry->hash.row_sum;
+        int64_t col_difference = hash.col_sum - entry->hash.col_sum;
+        if (row_difference % hash.population != 0 ||
+            col_difference % hash.population != 0) {
+            continue;
+        }
+        int64_t row_shift = row_difference / hash.population;
+        int64_t col_shift = col_difference / hash.population;
+        if ((row_shift == 0 && col_shift == 0) ||
+            row_shift <= -rows || row_shift >= rows ||
+            col_shift <= -cols || col_shift >= cols) {
+            continue;
+        }
+
+        uint64_t shifted = mul_mod(
+            entry->hash.polynomial,
+            row_shift >= 0 ? row_powers[row_shift]
+                           : row_inverse_powers[-row_shift]
+        );
+        shifted = mul_mod(
+            shifted,
+            col_shift >= 0 ? col_powers[col_shift]
+                           : col_inverse_powers[-col_shift]
+        );
+        if (shifted == hash.polynomial) {
+            cycle.period = period;
+            cycle.row_shift = row_shift;
+            cycle.col_shift = col_shift;
+            cycle.generation = generation;
+            return true;
+        }
+    }
+    return false;
+}
+
+void CycleDetector::reset(
+    const Board& board, uint64_t generation, uint64_t state_hash
+) {
+    if (board.rows != rows || board.cols != cols) {
+        rows = board.rows;
+        cols = board.cols;
+        fill_powers(row_powers, row_inverse_powers, ROW_BASE, rows);
+        fill_powers(col_powers, col_inverse_powers, COL_BASE, cols);
+    }
+    hash = BoardHash();
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < cols; col++) {
+            add_cell(row, col, board[row][col], 1);
+        }
+    }
+
+    table.fill(NO_GENERATION);
+    first_generation = generation;
+    cycle = Cycle();
+    remember(generation, state_hash);
+}
+
+void CycleDetector::edit(
+    const Board& old_board, const Board& board, const DirtyRect& changed,
+    uint64_t generation, uint64_t state_hash
+) {
+    apply_changes(old_board, board, changed);
+    first_generation = generation;
+    cycle = Cycle();
+    remember(generation, state_hash);
+}
+
+bool CycleDetector::step(
+    const Board& old_board, const Board& board, const DirtyRect& changed,
+    uint64_t generation, uint64_t state_hash
+) {
+    apply_changes(old_board, board, changed);
+    bool found = false;
+    if (!cycle.found()) {
+        // the rule set's own state (a turmite's ants) can't be shifted
+        found = find_exact(hash.zobrist ^ state_hash, generation) ||
+            (state_hash == 0 && find_translation(generation));
+    }
+    remember(generation, state_hash);
+    return found;
+}
@@ -0,0 +1,107 @@
+#ifndef CYCLE_DETECTOR_H
+#define CYCLE_DETECTOR_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "./common.h"
+
+// generations remembered; exact cycles up to this period are detected
+#define CYCLE_HISTORY 1024
+// slots of the table from board hash to generation (a power of two)
+#define CYCLE_TABLE_SIZE 4096
+// translating cycles (e.g. gliders) are looked for up to this period
+#define MAX_TRANSLATION_PERIOD 64
+
+struct Cycle {
+    int period = 0;
+    // displacement of the board over one period, in cells
+    int row_shift = 0;
+    int col_shift = 0;
+    // generation in which the cycle was noticed
+    uint64_t generation = 0;
+
+    bool found() const { return period > 0; }
+};
+
+// Hashes of a board that are kept up to date from the cells that changed,
+// at a cost proportional to the dirty rect rather than the board.
+struct BoardHash {
+    // Zobrist hash: the xor of a random key per (cell, state), with cells
+    // in state 0 adding nothing
+    uint64_t zobrist = 0;
+    // sum of key(state) * A^row * B^col modulo 2^61-1, which is multiplied
+    // by A^dr * B^dc when the board is shifted by (dr, dc) without wrapping
+    uint64_t polynomial = 0;
+    // number of live (non-zero) cells, and the sums of their coordinates
+    int64_t population = 0;
+    int64_t row_sum = 0;
+    int64_t col_sum = 0;
+};
+
+// Detects boards repeating a previous generation, either exactly or
+// shifted, by keeping a bounded history of board hashes.
+//
+// Shifted repeats are found by the change of the centroid of the live
+// cells, so patterns that wrap around the edge of the board during the
+// period are only found once they repeat exactly.
+class CycleDetector {
+    private:
+        struct Entry {
+            uint64_t generation;
+            // zobrist hash combined with the rule set's own state
+            uint64_t key;
+            BoardHash hash;
+        };
+
+        int rows = 0;
+        int cols = 0;
+        // A^i and A^-i for every row, B^i and B^-i for every column
+        std::vector<uint64_t> row_powers;
+        std::vector<uint64_t> row_inverse_powers;
+        std::vector<uint64_t> col_powers;
+        std::vector<uint64_t> col_inverse_powers;
+
+        BoardHash hash;
+        std::array<Entry, CYCLE_HISTORY> history;
+        // generation of the last key that went into each slot, by key
+        std::array<uint64_t, CYCLE_TABLE_SIZE> table;
+        // generations before this one aren't comparable with the board
+        uint64_t first_generation = 0;
+        uint64_t last_generation = 0;
+        Cycle cycle;
+
+        void add_cell(int row, int col, uint8_t state, int sign);
+        void apply_changes(const Board& old_board, const Board& board,
+                           const DirtyRect& changed);
+        void remember(uint64_t generation, uint64_t state_hash);
+        const Entry* find(uint64_t generation) const;
+        bool find_exact(uint64_t key, uint64_t generation);
+        bool find_translation(uint64_t generation);
+
+    public:
+        // hashes 'board' from scratch and forgets the history, e.g. after
+        // a resize or a change of rule set
+        void reset(const Board& board, uint64_t generation,
+                   uint64_t state_hash);
+        // the cells in 'changed' were edited from 'old_board' to 'board'
+        // without a generation passing; forgets the history
+        void edit(const Board& old_board, const Board& board,
+                  const DirtyRect& changed, uint64_t generation,
+                  uint64_t state_hash);
+        // 'board' is the generation after 'old_board', differing only in
+        // 'changed'. Returns true if this generation completes a cycle
+        // that wasn't found before. Shifted repeats are only looked for
+        // when 'state_hash' is 0.
+        bool step(const Board& old_board, const Board& board,
+                  const DirtyRect& changed, uint64_t generation,
+                  uint64_t state_hash);
+
+        // the cycle the board is in, if one was found since the history
+        // was last forgotten
+        const Cycle& get_cycle() const { return cycle; }
+        const BoardHash& get_hash() const { return hash; }
+};
+
+#endif
@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "./equivalence.h"
+#include "./common.h"
+#include "./parallel_rewrite.h"
+#include "./soup.h"
+#include "./automata/automata.h"
+
+// cells around a mismatch that are printed, in each direction
+#define MISMATCH_RADIUS 2
+
+// boards as rows x cols
+static const std::vector<std::pair<int, int>> board_sizes {
+    {1, 1}, {2, 3}, {5, 7}, {13, 11}, {32, 32}, {48, 37},
+};
+
+// A way of computing a generation, which must give the same result as
+// automata.rewrite().
+struct Engine {
+    std::string name;
+    // whether it splits the board into rows, so only works for rule sets
+    // that can_rewrite_rows()
+    bool needs_rows;
+    std::function<void(
+        CellularAutomata& automata, const Board& board, Board& board_copy,
+        StepContext& context
+    )> rewrite;
+};
+
+static void rewrite_in_bands(
+    CellularAutomata& automata, const Board& board, Board& board_copy,
+    StepContext& context, int band_rows
+) {
+    bool pixels_complete = true;
+    for (int row = 0; row < board.rows; row += band_rows) {
+        automata.rewrite_rows(
+            board, board_copy, context, row,
+            std::min(board.rows, row + band_rows)
+        );
+        pixels_complete &= context.pixels_complete;
+    }
+    context.pixels_complete = pixels_complete;
+}
+
+static std::vector<Engine> make_engines() {
+    std::vector<Engine> engines;
+    for (int band_rows : { 1, 7 }) {
+        engines.push_back({
+            "rows in bands of " + std::to_string(band_rows), true,
+            [band_rows](CellularAutomata& automata, const Board& board,
+                        Board& board_copy, StepContext& context) {
+                rewrite_in_bands(
+                    automata, board, board_copy, context, band_rows
+                );
+            }
+        });
+    }
+    for (int threads : { 2, 3 }) {
+        auto rewriter = std::make_shared<ParallelRewriter>(threads);
+        engines.push_back({
+            std::to_string(threads) + " threads", false,
+            [rewriter](CellularAutomata& automata, const Board& board,
+                       Board& board_copy, StepContext& context) {
+                rewriter->rewrite(automata, board, board_copy, context);
+            }
+        });
+    }
+    return engines;
+}
+
+// a distinct color for every state
+static std::array<uint32_t, 256> make_palette() {
+    std::array<uint32_t, 256> palette;
+    for (size_t i = 0; i < palette.size(); i++) {
+        palette[i] = 0xff000000 | (i * 0x010101);
+    }
+    return palette;
+}
+
+static void print_neighbourhood(
+    const Board& board, int row, int col, std::ostream& out
+) {
+    char cell[8];
+    for (int r = row - MISMATCH_RADIUS; r <= row + MISMATCH_RADIUS; r++) {
+        out << "    ";
+        for (int c = col - MISMATCH_RADIUS; c <= col + MISMATCH_RADIUS; c++) {
+            snprintf(
+                cell, sizeof(cell), r == row && c == col ? "[%3d]" : " %3d ",
+                board[modulo(r, board.rows)][modulo(c, board.cols)]
+            );
+            out << cell;
+        }
+        out << std::endl;
+    }
+}
+
+// Checks what a rewrite reported about the generation it computed from
+// 'board': every changed cell is within the dirty rect, and the pixels
+// match the new states. Returns an empty string if so.
+static std::string check_context(
+    const Board& board, const Board& next, const StepContext& context,
+    const std::vector<uint32_t>& pixels, const uint32_t* palette
+) {
+    char message[128];
+    for (int row = 0; row < board.rows; row++) {
+        for (int col = 0; col < board.cols; col++) {
+            bool changed = board[row][col] != next[row][col];
+            const DirtyRect& dirty = context.dirty;
+            if (changed && (row < dirty.min_row || row > dirty.max_row ||
+                            col < dirty.min_col || col > dirty.max_col)) {
+                snprintf(message, sizeof(message),
+                         "cell (%d, %d) changed outside the dirty rect",
+                         row, col);
+                return message;
+            }
+            if (!pixels.empty() &&
+                pixels[row * board.cols + col] != palette[next[row][col]]) {
+                snprintf(message, sizeof(message),
+                         "pixel (%d, %d) doesn't match state %d",
+                         row, col, next[row][col]);
+                return message;
+            }
+        }
+    }
+    return "";
+}
+
+// Runs a rule set under the reference rewrite() and 'engine' side by side.
+// Returns whether they agree.
+static bool check_engine(
+    const std::string& family, const std::string& rule, const Engine* engine,
+    int rows, int cols, const EquivalenceOptions& options, std::ostream& out
+) {
+    // rule sets with state of their own (turmites) need an instance each
+    CellularAutomataMap reference_registry = load_cellular_automata();
+    CellularAutomataMap engine_registry = load_cellular_automata();
+    CellularAutomata* reference =
+        find_cellular_automata(reference_registry, family, rule);
+    CellularAutomata* automata =
+        find_cellular_automata(engine_registry, family, rule);
+
+    Board expected(rows, cols);
+    if (dynamic_cast<Turmite*>(reference) == nullptr) {
+        fill_soup(expected, reference->num_states, options.seed);
+    }
+    Board actual = expected;
+    Board expected_next(rows, cols);
+    Board actual_next(rows, cols);
+
+    // the engine colorizes too, into pixels kept up to date across
+    // generations the way the renderer keeps them
+    static const std::array<uint32_t, 256> palette = make_palette();
+    std::vector<uint32_t> pixels;
+    if (engine != nullptr) {
+        for (uint8_t cell : actual.cells) {
+            pixels.push_back(palette[cell]);
+        }
+    }
+
+    std::string name = engine != nullptr ? engine->name : "rewrite()";
+    bool equal = true;
+    for (int generation = 1; generation <= options.generations; generation++) {
+        StepContext expected_context;
+        reference->rewrite(expected, expected_next, expected_context);
+
+        StepContext context;
+        if (engine != nullptr) {
+            context.palette = palette.data();
+            context.pixels = pixels.data();
+            engine->rewrite(*automata, actual, actual_next, context);
+        } else {
+            actual_next = expected_next;
+            context = expected_context;
+        }
+
+        std::string problem = check_context(
+            actual, actual_next, context, pixels, palette.data()
+        );
+        if (board_checksum(actual_next) != board_checksum(expected_next)) {
+            auto differs = std::mismatch(
+                actual_next.cells.begin(), actual_next.cells.end(),
+                expected_next.cells.begin()
+            );
+            int index = differs.first - actual_next.cells.begin();
+            int row = index / cols;
+            int col = index % cols;
+            out << "MISMATCH " << family << ": " << rule << " (" << name
+                << ") on " << rows << "x" << cols << ", generation "
+                << generation << ": cell (" << row << ", " << col
+                << ") is " << static_cast<int>(actual_next[row][col])
+                << ", expected " << static_cast<int>(expected_next[row][col])
+                << std::endl << "  neighbourhood in generation "
+                << generation - 1 << ":" << std::endl;
+            print_neighbourhood(expected, row, col, out);
+            equal = false;
+        } else if (!problem.empty()) {
+            out << "MISMATCH " << family << ": " << rule << " (" << name
+                << ") on " << rows << "x" << cols << ", generation "
+                << generation << ": " << problem << std::endl;
+            equal = false;
+        }
+        if (!equal) {
+            break;
+        }
+
+        std::swap(expected, expected_next);
+        std::swap(actual, actual_next);
+    }
+
+    for (CellularAutomataMap* registry :
+         { &reference_registry, &engine_registry }) {
+        for (auto& entry : *registry) {
+            for (CellularAutomata* automata : entry.second) {
+                delete automata;
+            }
+        }
+    }
+    return equal;
+}
+
+int check_equivalence(const EquivalenceOptions& options, std::ostream& out) {
+    init_neighbourhood_offsets();
+    std::vector<Engine> engines = make_engines();
+
+    std::vector<std::pair<std::string, std::string>> rule_sets;
+    CellularAutomataMap cellular_automata = load_cellular_automata();
+    for (auto& family : cellular_automata) {
+        for (CellularAutomata* automata : family.second) {
+            if ((options.family.empty() || options.family == family.first) &&
+                (options.rule.empty() || options.rule == automata->name)) {
+                rule_sets.emplace_back(family.first, automata->name);
+            }
+        }
+    }
+
+    int checks = 0;
+    int mismatches = 0;
+    for (auto& rule_set : rule_sets) {
+        CellularAutomata* automata = find_cellular_automata(
+            cellular_automata, rule_set.first, rule_set.second
+        );
+        bool rows_supported = automata->can_rewrite_rows();
+
+        for (auto& size : board_sizes) {
+            // the reference alone still checks the dirty rect
+            std::vector<const Engine*> checked { nullptr };
+            for (const Engine& engine : engines) {
+                if (rows_supported || !engine.needs_rows) {
+                    checked.push_back(&engine);
+                }
+            }
+            for (const Engine* engine : checked) {
+                checks++;
+                if (!check_engine(
+                        rule_set.first, rule_set.second, engine,
+                        size.first, size.second, options, out)) {
+                    mismatches++;
+                }
+            }
+        }
+    }
+
+    for (auto& family : cellular_automata) {
+        for (CellularAutomata* automata : family.second) {
+            delete automata;
+        }
+    }
+
+    out << rule_sets.size() << " rule sets, " << checks << " checks of "
+        << options.generations << " generations: " << mismatches
+        << " mismatch(es)" << std::endl;
+    return mismatches;
+}
@@ -0,0 +1,22 @@
+#ifndef EQUIVALENCE_H
+#define EQUIVALENCE_H
+
+#include <ostream>
+#include <string>
+
+struct EquivalenceOptions {
+    // only check this family/rule set when not empty
+    std::string family;
+    std::string rule;
+    int generations = 20;
+    unsigned seed = 1;
+};
+
+// Runs every rule set from random boards of several sizes (down to boards
+// smaller than the neighbourhood, where it wraps onto itself) under every
+// way the engine can compute a generation, and compares the board hash of
+// each generation with the plain rewrite(). The first cell that differs is
+// reported with its neighbourhood. Returns the number of mismatches.
+int check_equivalence(const EquivalenceOptions& options, std::ostream& out);
+
+#endif
@@ -0,0 +1,452 @@
+#include <iostream>
+#include <chrono>
+#include <cstdio>
+#include <climits>
+#include <string>
+#include <thread>
+#include <memory>
+#include <utility>
+#include <algorithm>
+
+#include "./common.h"
+#include "./automata/automata.h"
+#include "./parallel_rewrite.h"
+#include "./equivalence.h"
+#include "./allocation_check.h"
+#include "./allocation_tracker.h"
+#include "./stats_writer.h"
+#include "./phase_timer.h"
+#include "./sampling_profiler.h"
+#include "./session.h"
+#include "./metrics_server.h"
+#include "./soup.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+// Runs a rule set on a random board as fast as possible without drawing
+// anything, then prints the throughput and checksums of the final board.
+// With --verify, checks instead that every way of computing generations
+// gives the same boards, and with --allocations, that the engine doesn't
+// allocate. --replay reruns a session recorded by the window.
+
+#define DEFAULT_FAMILY "Life"
+#define DEFAULT_RULE "Conway's Life"
+#define DEFAULT_SIZE 512
+#define DEFAULT_GENERATIONS 1000
+// phases are collected for the metrics this often
+#define METRICS_COLLECT_MS 100
+
+struct Options {
+    // empty or -1 when not given, since --verify and --allocations have
+    // other defaults
+    std::string family;
+    std::string rule;
+    int size = -1;
+    unsigned seed = 1;
+    // density, weights of the states and symmetry of the random board
+    SoupOptions soup;
+    int generations = -1;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    // file the statistics of every generation are written to, if any
+    std::string stats_path;
+    // file a Chrome trace of every generation is written to, if any
+    std::string trace_path;
+    // file the sampled stacks are written to in the folded format, if any
+    std::string profile_path;
+    // session replayed instead, if any
+    std::string replay_path;
+    // local port the metrics are served on, if any (0 for any free one)
+    int metrics_port = -1;
+    bool list = false;
+    bool verify = false;
+    bool allocations = false;
+};
+
+static void print_usage(const char* program) {
+    cerr << "usage: " << program << " [options]" << endl
+         << "  --family NAME       rule family (default: Life)" << endl
+         << "  --rule NAME         rule set in the family"
+         << " (default: Conway's Life)" << endl
+         << "  --size N            board of N x N cells (default: 512)" << endl
+         << "  --seed N            seed of the random board (default: 1)"
+         << endl
+         << "  --density D         fraction of the random board in a state"
+         << endl
+         << "                      other than 0 (default: every state is"
+         << endl
+         << "                      as likely)" << endl
+         << "  --weights W0,W1,... relative weights of the states of the"
+         << endl
+         << "                      random board" << endl
+         << "  --symmetry NAME     make the random board symmetric: none,"
+         << endl
+         << "                      columns, rows, both, rotate2 or rotate4"
+         << endl
+         << "  --generations N     generations to run (default: 1000)"
+         << endl
+         << "  --threads N         threads computing generations"
+         << " (default: all cores)" << endl
+         << "  --stats FILE        write the statistics of every generation"
+         << endl
+         << "                      to FILE (.jsonl for JSON Lines, or CSV)"
+         << endl
+         << "  --trace FILE        write a Chrome trace of every generation"
+         << " and" << endl
+         << "                      the tasks of its threads to FILE" << endl
+         << "  --profile FILE      sample the stacks of the threads and write"
+         << endl
+         << "                      them to FILE as folded stacks, for flame"
+         << endl
+         << "                      graphs" << endl
+         << "  --metrics PORT      serve Prometheus metrics of the run on"
+         << endl
+         << "                      http://127.0.0.1:PORT/metrics" << endl
+         << "  --list              list the rule sets and exit" << endl
+         << "  --verify            compare every engine with the reference"
+         << endl
+         << "                      rewrite() instead, for every rule set"
+         << " unless" << endl
+         << "                      --family/--rule are given (default: "
+         << EquivalenceOptions().generations << " generations)" << endl
+         << "  --allocations       count the allocations of every rule set"
+         << endl
+         << "                      and check that the engine adds none"
+         << endl
+         << "                      (needs -DTOMATO_TRACK_ALLOCATIONS=ON;"
+         << " default:" << endl
+         << "                      " << AllocationCheckOptions().size << "x"
+         << AllocationCheckOptions().size << ", "
+         << AllocationCheckOptions().generations << " generations)" << endl
+         << "  --replay FILE       replay a session recorded by the window"
+         << " as" << endl
+         << "                      fast as possible and check its boards"
+         << endl;
+}
+
+static bool parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--list") {
+            options.list = true;
+            continue;
+        }
+        if (option == "--verify") {
+            options.verify = true;
+            continue;
+        }
+        if (option == "--allocations") {
+            options.allocations = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+
+        try {
+            if (option == "--family") {
+                options.family = value;
+            } else if (option == "--rule") {
+                options.rule = value;
+            } else if (option == "--size") {
+                options.size = std::stoi(value);
+            } else if (option == "--seed") {
+                options.seed = std::stoul(value);
+            } else if (option == "--density") {
+                options.soup.density = std::stod(value);
+                if (options.soup.density < 0) {
+                    return false;
+                }
+            } else if (option == "--weights") {
+                options.soup.weights.clear();
+                for (const std::string& weight : split(value, ',')) {
+                    options.soup.weights.push_back(std::stod(weight));
+                }
+            } else if (option == "--symmetry") {
+                if (!parse_soup_symmetry(value, options.soup.symmetry)) {
+                    return false;
+                }
+            } else if (option == "--generations") {
+                options.generations = std::stoi(value);
+            } else if (option == "--threads") {
+                options.threads = std::stoi(value);
+            } else if (option == "--stats") {
+                options.stats_path = value;
+            } else if (option == "--trace") {
+                options.trace_path = value;
+            } else if (option == "--profile") {
+                options.profile_path = value;
+            } else if (option == "--metrics") {
+                options.metrics_port = std::stoi(value);
+            } else if (option == "--replay") {
+                options.replay_path = value;
+            } else {
+                return false;
+            }
+        } catch (const std::exception&) {
+            return false;
+        }
+    }
+
+    // the cells are indexed by int
+    return (options.size > 0 || options.size == -1) &&
+        int64_t(options.size) * options.size <= INT_MAX &&
+        options.generations >= -1 &&
+        options.threads > 0 &&
+        options.metrics_port >= -1 && options.metrics_port <= 65535;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    if (options.verify) {
+        EquivalenceOptions equivalence;
+        equivalence.family = options.family;
+        equivalence.rule = options.rule;
+        equivalence.seed = options.seed;
+        if (options.generations >= 0) {
+            equivalence.generations = options.generations;
+        }
+        return check_equivalence(equivalence, cout) == 0 ? 0 : 1;
+    }
+    if (!options.replay_path.empty()) {
+        return replay_session(options.replay_path, cout) == 0 ? 0 : 1;
+    }
+    if (options.allocations) {
+        AllocationCheckOptions allocation_check;
+        allocation_check.family = options.family;
+        allocation_check.rule = options.rule;
+        allocation_check.seed = options.seed;
+        allocation_check.threads = options.threads;
+        if (options.size > 0) {
+            allocation_check.size = options.size;
+        }
+        if (options.generations >= 0) {
+            allocation_check.generations = options.generations;
+        }
+        return check_allocations(allocation_check, cout) == 0 ? 0 : 1;
+    }
+    if (options.family.empty()) {
+        options.family = DEFAULT_FAMILY;
+    }
+    if (options.rule.empty()) {
+        options.rule = DEFAULT_RULE;
+    }
+    if (options.size < 0) {
+        options.size = DEFAULT_SIZE;
+    }
+    if (options.generations < 0) {
+        options.generations = DEFAULT_GENERATIONS;
+    }
+
+    init_neighbourhood_offsets();
+    CellularAutomataMap cellular_automata = load_cellular_automata();
+
+    if (options.list) {
+        for (auto& family : cellular_automata) {
+            for (CellularAutomata* automata : family.second) {
+                cout << family.first << ": " << automata->name << endl;
+            }
+        }
+        return 0;
+    }
+
+    CellularAutomata* automata = find_cellular_automata(
+        cellular_automata, options.family, options.rule
+    );
+    if (automata == nullptr) {
+        cerr << "unknown rule set '" << options.family << ": "
+             << options.rule << "' (see --list)" << endl;
+        return 1;
+    }
+
+    std::string soup_error;
+    if (!check_soup_options(automata->num_states, options.soup, soup_error)) {
+        cerr << "can't make the random board: " << soup_error << endl;
+        return 1;
+    }
+
+    Board board(options.size, options.size);
+    Board board_copy(options.size, options.size);
+
+    std::unique_ptr<StatsWriter> stats_writer;
+    if (!options.stats_path.empty()) {
+        stats_writer = std::make_unique<StatsWriter>(
+            options.stats_path, automata->num_states
+        );
+        if (!stats_writer->is_open()) {
+            cerr << "couldn't open " << options.stats_path << endl;
+            return 1;
+        }
+    }
+    GenerationStats record;
+    record.num_states = automata->num_states;
+
+    TraceCapture trace_capture;
+    std::vector<PhaseEvent> phase_events;
+    if (!options.trace_path.empty()) {
+        if (!trace_capture.start(options.trace_path, options.generations)) {
+            cerr << "couldn't open " << options.trace_path << endl;
+            return 1;
+        }
+        name_phase_thread("main");
+        set_phase_timing(true);
+    }
+
+    SamplingProfiler profiler;
+    if (!options.profile_path.empty() && !profiler.start()) {
+        cerr << "couldn't start the sampling profiler" << endl;
+        return 1;
+    }
+
+    ParallelRewriter rewriter(options.threads);
+
+    // turmites start on an empty board
+    auto fill_start = std::chrono::steady_clock::now();
+    if (dynamic_cast<Turmite*>(automata) == nullptr) {
+        fill_soup(board, automata->num_states, options.seed, options.soup,
+                  &rewriter.thread_pool());
+    }
+    double fill_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - fill_start
+    ).count();
+    uint64_t initial_checksum = board_checksum(board);
+
+    MetricsServer metrics;
+    auto next_metrics_time = std::chrono::steady_clock::now();
+    uint64_t board_bytes = 2 * board.cells.size();
+    if (options.metrics_port >= 0) {
+        std::string error;
+        if (!metrics.start(options.metrics_port, error)) {
+            cerr << "couldn't serve metrics: " << error << endl;
+            return 1;
+        }
+        cerr << "serving metrics on http://127.0.0.1:" << metrics.get_port()
+             << "/metrics" << endl;
+        metrics.set_run(options.family, automata->name, rewriter.threads(),
+                        board.rows, board.cols);
+        metrics.set_progress(0, 0, 1, board_bytes);
+        name_phase_thread("main");
+        set_phase_timing(true);
+    }
+
+    AllocationScope allocation_scope(AllocationPhase::Step);
+    AllocationCounts allocations_start =
+        allocation_counts(AllocationPhase::Step);
+    auto start_time = std::chrono::steady_clock::now();
+    for (int generation = 0; generation < options.generations; generation++) {
+        StepContext context;
+        if (stats_writer != nullptr) {
+            record.stats = StepStats();
+            context.stats = &record.stats;
+        }
+        {
+            PhaseTimer timer("generation");
+            rewriter.rewrite(*automata, board, board_copy, context);
+        }
+        std::swap(board, board_copy);
+        if (stats_writer != nullptr) {
+            record.generation = generation + 1;
+            stats_writer->write_all(record);
+        }
+        // the metrics are fed between generations, every so often
+        bool feed_metrics = metrics.is_running() &&
+            (generation + 1 == options.generations ||
+             std::chrono::steady_clock::now() >= next_metrics_time);
+        bool collect = trace_capture.is_capturing() || feed_metrics;
+        if (collect) {
+            phase_events.clear();
+            collect_phases(phase_events);
+        }
+        if (trace_capture.is_capturing()) {
+            trace_capture.add(phase_events);
+            trace_capture.end_frame();
+        }
+        if (collect && metrics.is_running()) {
+            metrics.add_phases(phase_events);
+        }
+        if (feed_metrics) {
+            const DirtyRect& dirty = context.dirty;
+            double dirty_cells = dirty.empty() ? 0 :
+                static_cast<double>(dirty.max_row - dirty.min_row + 1) *
+                (dirty.max_col - dirty.min_col + 1);
+            uint64_t generations = generation + 1;
+            metrics.set_progress(
+                generations, generations * board.cells.size(),
+                dirty_cells / board.cells.size(), board_bytes
+            );
+            next_metrics_time = std::chrono::steady_clock::now() +
+                std::chrono::milliseconds(METRICS_COLLECT_MS);
+        }
+    }
+    double seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start_time
+    ).count();
+    AllocationCounts allocations_end =
+        allocation_counts(AllocationPhase::Step);
+
+    if (profiler.is_running()) {
+        profiler.stop();
+        if (!profiler.write_folded(options.profile_path)) {
+            cerr << "couldn't write " << options.profile_path << endl;
+            return 1;
+        }
+    }
+
+    // cells in each state
+    std::vector<uint64_t> populations(256);
+    for (uint8_t cell : board.cells) {
+        populations[cell]++;
+    }
+
+    double cells = static_cast<double>(board.rows) * board.cols;
+    double rate = seconds > 0 ? options.generations / seconds : 0;
+    char checksum[2][17];
+    snprintf(checksum[0], sizeof(checksum[0]), "%016llx",
+             static_cast<unsigned long long>(initial_checksum));
+    snprintf(checksum[1], sizeof(checksum[1]), "%016llx",
+             static_cast<unsigned long long>(board_checksum(board)));
+
+    cout << "rule set:          " << options.family << ": "
+         << automata->name << " (" << automata->rules << ")" << endl
+         << "board:             " << board.rows << "x" << board.cols
+         << ", seed " << options.seed << ", filled in " << fill_ms << " ms"
+         << endl
+         << "threads:           " << rewriter.threads() << endl
+         << "generations:       " << options.generations << " in "
+         << seconds << " s" << endl
+         << "generations/s:     " << rate << endl
+         << "cells/s:           " << rate * cells << endl
+         << "initial checksum:  " << checksum[0] << endl
+         << "final checksum:    " << checksum[1] << endl
+         << "final population:";
+    for (size_t state = 0; state < populations.size(); state++) {
+        if (populations[state] > 0) {
+            cout << " " << state << ":" << populations[state];
+        }
+    }
+    cout << endl;
+    if (allocation_tracking) {
+        double generations = std::max(1, options.generations);
+        uint64_t allocations =
+            allocations_end.allocations - allocations_start.allocations;
+        cout << "allocations/gen:   " << allocations / generations
+             << " (" << allocations / (generations * cells) << "/cell, "
+             << (allocations_end.bytes - allocations_start.bytes) / generations
+             << " bytes)" << endl;
+    }
+
+    for (auto& family : cellular_automata) {
+        for (CellularAutomata* automata : family.second) {
+            delete automata;
+        }
+    }
+
+    return 0;
+}
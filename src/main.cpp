@@ -1,9 +1,12 @@
 #include <SDL2/SDL.h>
 #include <iostream>
 #include <chrono>
+#include <algorithm>
+#include <string>
 using namespace std::chrono;
 
 using std::cout;
+using std::cerr;
 using std::endl;
 
 #include "../imgui/imgui.h"
@@ -13,7 +16,66 @@ using std::endl;
 
 #define WINDOW_SIZE 900
 
-int main() {
+static const char* get_clipboard_text(void*) {
+    static char* text = nullptr;
+    SDL_free(text);
+    text = SDL_GetClipboardText();
+    return text;
+}
+
+static void set_clipboard_text(void*, const char* text) {
+    SDL_SetClipboardText(text);
+}
+
+// lets ImGui's text fields be typed in: keys are indexed by SDL scancode
+static void init_keyboard(ImGuiIO& io) {
+    io.KeyMap[ImGuiKey_Tab] = SDL_SCANCODE_TAB;
+    io.KeyMap[ImGuiKey_LeftArrow] = SDL_SCANCODE_LEFT;
+    io.KeyMap[ImGuiKey_RightArrow] = SDL_SCANCODE_RIGHT;
+    io.KeyMap[ImGuiKey_UpArrow] = SDL_SCANCODE_UP;
+    io.KeyMap[ImGuiKey_DownArrow] = SDL_SCANCODE_DOWN;
+    io.KeyMap[ImGuiKey_PageUp] = SDL_SCANCODE_PAGEUP;
+    io.KeyMap[ImGuiKey_PageDown] = SDL_SCANCODE_PAGEDOWN;
+    io.KeyMap[ImGuiKey_Home] = SDL_SCANCODE_HOME;
+    io.KeyMap[ImGuiKey_End] = SDL_SCANCODE_END;
+    io.KeyMap[ImGuiKey_Insert] = SDL_SCANCODE_INSERT;
+    io.KeyMap[ImGuiKey_Delete] = SDL_SCANCODE_DELETE;
+    io.KeyMap[ImGuiKey_Backspace] = SDL_SCANCODE_BACKSPACE;
+    io.KeyMap[ImGuiKey_Space] = SDL_SCANCODE_SPACE;
+    io.KeyMap[ImGuiKey_Enter] = SDL_SCANCODE_RETURN;
+    io.KeyMap[ImGuiKey_Escape] = SDL_SCANCODE_ESCAPE;
+    io.KeyMap[ImGuiKey_KeyPadEnter] = SDL_SCANCODE_KP_ENTER;
+    io.KeyMap[ImGuiKey_A] = SDL_SCANCODE_A;
+    io.KeyMap[ImGuiKey_C] = SDL_SCANCODE_C;
+    io.KeyMap[ImGuiKey_V] = SDL_SCANCODE_V;
+    io.KeyMap[ImGuiKey_X] = SDL_SCANCODE_X;
+    io.KeyMap[ImGuiKey_Y] = SDL_SCANCODE_Y;
+    io.KeyMap[ImGuiKey_Z] = SDL_SCANCODE_Z;
+    io.GetClipboardTextFn = get_clipboard_text;
+    io.SetClipboardTextFn = set_clipboard_text;
+}
+
+int main(int argc, char* argv[]) {
+    // a session can be recorded to a file, or replayed from one
+    std::string record_path;
+    std::string replay_path;
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--record" && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (option == "--replay" && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else {
+            cerr << "usage: " << argv[0]
+                 << " [--record FILE | --replay FILE]" << endl;
+            return 1;
+        }
+    }
+    if (!record_path.empty() && !replay_path.empty()) {
+        cerr << "a session can't be recorded while replaying one" << endl;
+        return 1;
+    }
+
     // initialize SDL
     SDL_Init(SDL_INIT_EVERYTHING);
     SDL_Window* window = SDL_CreateWindow(
@@ -29,24 +91,41 @@ int main() {
 
     ImGui::CreateContext();
     ImGuiSDL::Initialize(renderer, WINDOW_SIZE, WINDOW_SIZE);
+    init_keyboard(ImGui::GetIO());
+    SDL_StartTextInput();
 
     // initialize the App with the SDL renderer
-    App* app = new App(renderer);
+    App* app = new App(renderer, record_path, replay_path);
+    if (!app->get_session_error().empty()) {
+        cerr << app->get_session_error() << endl;
+        delete app;
+        ImGuiSDL::Deinitialize();
+        SDL_DestroyRenderer(renderer);
+        SDL_DestroyWindow(window);
+        ImGui::DestroyContext();
+        return 1;
+    }
 
     auto start_time = high_resolution_clock::now();
 
     bool running = true;
     while (running) {
         auto now = high_resolution_clock::now();
-        auto delta_time_ms = duration_cast<milliseconds>(now - start_time);
+        auto delta_time = duration_cast<duration<float>>(now - start_time);
         start_time = now;
 
         ImGuiIO& io = ImGui::GetIO();
 
         int wheel = 0;
 
+        // while nothing can change, sleep until there is input instead of
+        // drawing the same frame over and over
+        bool idle = app->is_idle();
         SDL_Event e;
-        while (SDL_PollEvent(&e)) {
+        bool have_event = idle ?
+            SDL_WaitEventTimeout(&e, IDLE_WAIT_MS) : SDL_PollEvent(&e);
+        while (have_event) {
+            app->request_redraw();
             switch (e.type) {
                 case SDL_QUIT: {
                     running = false;
@@ -60,10 +139,35 @@ int main() {
                 case SDL_MOUSEWHEEL: {
                     wheel = e.wheel.y;
                 } break;
+                // timestamped for the latency of painting
+                case SDL_MOUSEBUTTONDOWN: {
+                    app->note_input(e.button.timestamp);
+                } break;
+                case SDL_MOUSEMOTION: {
+                    app->note_input(e.motion.timestamp);
+                } break;
+                case SDL_TEXTINPUT: {
+                    io.AddInputCharactersUTF8(e.text.text);
+                } break;
+                case SDL_KEYUP:
                 case SDL_KEYDOWN: {
+                    int key = e.key.keysym.scancode;
+                    if (key >= 0 && key < IM_ARRAYSIZE(io.KeysDown)) {
+                        io.KeysDown[key] = e.type == SDL_KEYDOWN;
+                    }
+                    SDL_Keymod mods = SDL_GetModState();
+                    io.KeyShift = (mods & KMOD_SHIFT) != 0;
+                    io.KeyCtrl = (mods & KMOD_CTRL) != 0;
+                    io.KeyAlt = (mods & KMOD_ALT) != 0;
+                    io.KeySuper = (mods & KMOD_GUI) != 0;
+
+                    // keys typed into a text field aren't shortcuts
+                    if (e.type != SDL_KEYDOWN || io.WantCaptureKeyboard) {
+                        break;
+                    }
                     switch (e.key.keysym.sym) {
                         case SDLK_SPACE:
-                            app->paused = !app->paused;
+                            app->toggle_paused();
                             break;
                         case SDLK_ESCAPE:
                             running = false;
@@ -71,9 +175,28 @@ int main() {
                         case SDLK_h:
                             app->show_gui = !app->show_gui;
                             break;
+                        case SDLK_0:
+                            app->reset_view();
+                            break;
+                        case SDLK_p:
+                            app->show_performance = !app->show_performance;
+                            break;
+                        case SDLK_s:
+                            app->show_statistics = !app->show_statistics;
+                            break;
+                        case SDLK_t:
+                            app->show_timings = !app->show_timings;
+                            break;
                     }
                 } break;
             }
+            have_event = SDL_PollEvent(&e);
+        }
+
+        // nothing happened while waiting, though the performance overlay
+        // still shows figures that change
+        if (app->is_idle() && !app->show_performance) {
+            continue;
         }
 
         int mouseX, mouseY;
@@ -81,16 +204,19 @@ int main() {
 
         // Setup low-level inputs (e.g. on Win32, GetKeyboardState(), or write to those fields from your Windows message loop handlers, etc.)
         
-        //io.DeltaTime = delta_time.count();
+        io.DeltaTime = std::max(delta_time.count(), 0.0001f);
         io.MousePos = ImVec2(static_cast<float>(mouseX), static_cast<float>(mouseY));
         io.MouseDown[0] = buttons & SDL_BUTTON(SDL_BUTTON_LEFT);
         io.MouseDown[1] = buttons & SDL_BUTTON(SDL_BUTTON_RIGHT);
+        io.MouseDown[2] = buttons & SDL_BUTTON(SDL_BUTTON_MIDDLE);
         io.MouseWheel = static_cast<float>(wheel);
 
         app->render(io);
-        app->update(io, delta_time_ms.count());
+        app->update(io);
     }
 
+    delete app;
+
     ImGuiSDL::Deinitialize();
 
     SDL_DestroyRenderer(renderer);
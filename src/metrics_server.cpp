@@ -0,0 +1,409 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+#include "./metrics_server.h"
+
+#ifdef __linux__
+#include <cerrno>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+// how long a client may take to send its request
+#define METRICS_REQUEST_TIMEOUT_MS 1000
+
+//
+// text format
+//
+
+static std::string format_number(double value) {
+    char text[32];
+    snprintf(text, sizeof(text), "%.9g", value);
+    return text;
+}
+
+static std::string escape_label(const std::string& value) {
+    std::string escaped;
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+static void add_header(
+    std::string& out, const char* name, const char* type, const char* help
+) {
+    out += std::string("# HELP ") + name + " " + help + "\n";
+    out += std::string("# TYPE ") + name + " " + type + "\n";
+}
+
+static void add_sample(
+    std::string& out, const std::string& name, const std::string& labels,
+    const std::string& value
+) {
+    out += name;
+    if (!labels.empty()) {
+        out += "{" + labels + "}";
+    }
+    out += " " + value + "\n";
+}
+
+static void add_sample(
+    std::string& out, const std::string& name, const std::string& labels,
+    double value
+) {
+    add_sample(out, name, labels, format_number(value));
+}
+
+// counts are written in full, unlike doubles
+static void add_count(
+    std::string& out, const std::string& name, const std::string& labels,
+    uint64_t value
+) {
+    add_sample(out, name, labels, std::to_string(value));
+}
+
+// resident set size of the process, or 0 where it can't be read
+static uint64_t resident_bytes() {
+#ifdef __linux__
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0;
+    uint64_t resident = 0;
+    if (statm >> size >> resident) {
+        return resident * sysconf(_SC_PAGESIZE);
+    }
+#endif
+    return 0;
+}
+
+//
+// feeding
+//
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+void MetricsServer::set_run(
+    const std::string& _family, const std::string& _rule, int _threads,
+    int _rows, int _cols
+) {
+    std::lock_guard<std::mutex> lock(mutex);
+    family = _family;
+    rule = _rule;
+    threads = _threads;
+    rows = _rows;
+    cols = _cols;
+}
+
+void MetricsServer::add_phases(const std::vector<PhaseEvent>& events) {
+    // the time a thread was busy is the union of its phases, which nest
+    std::vector<std::vector<std::pair<uint64_t, uint64_t>>> spans;
+    for (const PhaseEvent& event : events) {
+        if (event.thread >= static_cast<int>(spans.size())) {
+            spans.resize(event.thread + 1);
+        }
+        spans[event.thread].emplace_back(event.start_ns, event.end_ns);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const PhaseEvent& event : events) {
+        Histogram& histogram = phases[event.name];
+        double seconds = (event.end_ns - event.start_ns) / 1e9;
+        double bound = METRICS_FIRST_BUCKET_SECONDS;
+        for (int i = 0; i < METRICS_BUCKETS; i++, bound *= 2) {
+            if (seconds <= bound) {
+                histogram.counts[i]++;
+                break;
+            }
+        }
+        histogram.count++;
+        histogram.sum_seconds += seconds;
+    }
+
+    if (busy_seconds.size() < spans.size()) {
+        busy_seconds.resize(spans.size());
+    }
+    for (size_t thread = 0; thread < spans.size(); thread++) {
+        auto& thread_spans = spans[thread];
+        std::sort(thread_spans.begin(), thread_spans.end());
+        uint64_t busy_ns = 0;
+        uint64_t covered_ns = 0;
+        for (auto& span : thread_spans) {
+            uint64_t start_ns = std::max(span.first, covered_ns);
+            if (span.second > start_ns) {
+                busy_ns += span.second - start_ns;
+                covered_ns = span.second;
+            }
+        }
+        busy_seconds[thread] += busy_ns / 1e9;
+    }
+}
+
+void MetricsServer::set_progress(
+    uint64_t _generations, uint64_t _cells, double _dirty_fraction,
+    uint64_t _board_bytes
+) {
+    std::lock_guard<std::mutex> lock(mutex);
+    generations = _generations;
+    cells = _cells;
+    dirty_fraction = _dirty_fraction;
+    board_bytes = _board_bytes;
+
+    Clock::time_point now = Clock::now();
+    double seconds = std::chrono::duration<double>(now - rate_time).count();
+    // the first figures only start the measurement
+    if (rate_started && seconds < METRICS_RATE_SECONDS) {
+        return;
+    }
+    if (!rate_started) {
+        rate_started = true;
+        rate_time = now;
+        rate_generations = generations;
+        rate_cells = cells;
+        rate_busy_seconds = busy_seconds;
+        return;
+    }
+    generations_per_second = (generations - rate_generations) / seconds;
+    cells_per_second = (cells - rate_cells) / seconds;
+    rate_busy_seconds.resize(busy_seconds.size());
+    utilization.resize(busy_seconds.size());
+    for (size_t thread = 0; thread < busy_seconds.size(); thread++) {
+        utilization[thread] =
+            (busy_seconds[thread] - rate_busy_seconds[thread]) / seconds;
+    }
+    rate_time = now;
+    rate_generations = generations;
+    rate_cells = cells;
+    rate_busy_seconds = busy_seconds;
+}
+
+std::string MetricsServer::render() {
+    std::vector<std::string> thread_names = phase_thread_names();
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string out;
+
+    add_header(out, "tomato_info", "gauge", "The rule set being run.");
+    add_count(out, "tomato_info",
+              "family=\"" + escape_label(family) + "\",rule=\"" +
+              escape_label(rule) + "\",threads=\"" +
+              std::to_string(threads) + "\",rows=\"" +
+              std::to_string(rows) + "\",cols=\"" + std::to_string(cols) +
+              "\"", 1);
+
+    add_header(out, "tomato_generations_total", "counter",
+               "Generations computed.");
+    add_count(out, "tomato_generations_total", "", generations);
+    add_header(out, "tomato_cells_total", "counter", "Cells rewritten.");
+    add_count(out, "tomato_cells_total", "", cells);
+    add_header(out, "tomato_generations_per_second", "gauge",
+               "Generations per second over the last second or so.");
+    add_sample(out, "tomato_generations_per_second", "",
+               generations_per_second);
+    add_header(out, "tomato_cells_per_second", "gauge",
+               "Cells rewritten per second over the last second or so.");
+    add_sample(out, "tomato_cells_per_second", "", cells_per_second);
+    add_header(out, "tomato_dirty_fraction", "gauge",
+               "Fraction of the board in the bounding box of the cells the"
+               " last generation changed.");
+    add_sample(out, "tomato_dirty_fraction", "", dirty_fraction);
+
+    add_header(out, "tomato_board_bytes", "gauge",
+               "Memory of the boards being rewritten.");
+    add_count(out, "tomato_board_bytes", "", board_bytes);
+    uint64_t resident = resident_bytes();
+    if (resident > 0) {
+        add_header(out, "tomato_resident_memory_bytes", "gauge",
+                   "Resident memory of the process, boards and caches"
+                   " included.");
+        add_count(out, "tomato_resident_memory_bytes", "", resident);
+    }
+
+    add_header(out, "tomato_phase_duration_seconds", "histogram",
+               "Durations of the phases of the generations.");
+    for (auto& phase : phases) {
+        std::string name = "phase=\"" + escape_label(phase.first) + "\"";
+        const Histogram& histogram = phase.second;
+        uint64_t cumulative = 0;
+        double bound = METRICS_FIRST_BUCKET_SECONDS;
+        for (int i = 0; i < METRICS_BUCKETS; i++, bound *= 2) {
+            cumulative += histogram.counts[i];
+            add_count(out, "tomato_phase_duration_seconds_bucket",
+                      name + ",le=\"" + format_number(bound) + "\"",
+                      cumulative);
+        }
+        add_count(out, "tomato_phase_duration_seconds_bucket",
+                  name + ",le=\"+Inf\"", histogram.count);
+        add_sample(out, "tomato_phase_duration_seconds_sum", name,
+                   histogram.sum_seconds);
+        add_count(out, "tomato_phase_duration_seconds_count", name,
+                  histogram.count);
+    }
+    add_header(out, "tomato_phases_dropped_total", "counter",
+               "Phases lost because a thread recorded them faster than"
+               " they were collected.");
+    add_count(out, "tomato_phases_dropped_total", "", dropped_phases());
+
+    add_header(out, "tomato_thread_busy_seconds_total", "counter",
+               "Time each thread spent in phases.");
+    std::vector<std::string> thread_labels;
+    for (size_t thread = 0; thread < busy_seconds.size(); thread++) {
+        std::string name = thread < thread_names.size() ?
+            thread_names[thread] : "";
+        thread_labels.push_back(
+            "thread=\"" + std::to_string(thread) + "\",name=\"" +
+            escape_label(name) + "\""
+        );
+        add_sample(out, "tomato_thread_busy_seconds_total",
+                   thread_labels[thread], busy_seconds[thread]);
+    }
+    add_header(out, "tomato_thread_utilization", "gauge",
+               "Fraction of the last second or so each thread spent in"
+               " phases.");
+    for (size_t thread = 0; thread < utilization.size(); thread++) {
+        add_sample(out, "tomato_thread_utilization", thread_labels[thread],
+                   utilization[thread]);
+    }
+    return out;
+}
+
+//
+// serving
+//
+
+#ifdef __linux__
+
+bool MetricsServer::start(int _port, std::string& error) {
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd == -1) {
+        error = strerror(errno);
+        return false;
+    }
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(_port);
+    socklen_t length = sizeof(address);
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), length) == -1 ||
+        listen(fd, 8) == -1 ||
+        getsockname(fd, reinterpret_cast<sockaddr*>(&address), &length)
+            == -1) {
+        error = strerror(errno);
+        close(fd);
+        fd = -1;
+        return false;
+    }
+    port = ntohs(address.sin_port);
+
+    stopping = false;
+    thread = std::thread(&MetricsServer::serve, this);
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (fd == -1) {
+        return;
+    }
+    stopping = true;
+    thread.join();
+    close(fd);
+    fd = -1;
+}
+
+// answers one request at a time, checking every so often whether to stop
+void MetricsServer::serve() {
+    name_phase_thread("metrics");
+    while (!stopping) {
+        pollfd listening { fd, POLLIN, 0 };
+        if (poll(&listening, 1, 100) <= 0) {
+            continue;
+        }
+        int client = accept(fd, nullptr, nullptr);
+        if (client == -1) {
+            continue;
+        }
+        timeval timeout {
+            METRICS_REQUEST_TIMEOUT_MS / 1000,
+            (METRICS_REQUEST_TIMEOUT_MS % 1000) * 1000
+        };
+        setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+                   sizeof(timeout));
+        respond(client);
+        close(client);
+    }
+}
+
+void MetricsServer::respond(int client) {
+    // only the request line matters
+    std::string request;
+    char buffer[1024];
+    while (request.find("\r\n\r\n") == std::string::npos &&
+           request.size() < 8192) {
+        ssize_t received = recv(client, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+            break;
+        }
+        request.append(buffer, received);
+    }
+
+    std::string status = "200 OK";
+    std::string body;
+    if (request.compare(0, 13, "GET /metrics ") == 0 ||
+        request.compare(0, 6, "GET / ") == 0) {
+        body = render();
+    } else {
+        status = "404 Not Found";
+        body = "see /metrics\n";
+    }
+    std::string response =
+        "HTTP/1.0 " + status + "\r\n"
+        "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+        "Content-Length: " + std::to_string(body.size()) + "\r\n"
+        "Connection: close\r\n\r\n" + body;
+
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t written = send(client, response.data() + sent,
+                               response.size() - sent, MSG_NOSIGNAL);
+        if (written <= 0) {
+            break;
+        }
+        sent += written;
+    }
+}
+
+#else
+
+// other systems aren't supported yet
+bool MetricsServer::start(int, std::string& error) {
+    error = "not supported on this system";
+    return false;
+}
+
+void MetricsServer::stop() {
+}
+
+void MetricsServer::serve() {
+}
+
+void MetricsServer::respond(int) {
+}
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./phase_timer.h"
+
+// buckets of the phase duration histograms, doubling from 10 us (the last
+// is about 5 s; longer phases only count towards +Inf)
+#define METRICS_BUCKETS 20
+#define METRICS_FIRST_BUCKET_SECONDS 1e-5
+// the rates are measured over at least this long
+#define METRICS_RATE_SECONDS 1.0
+
+// Serves the progress of a run as Prometheus metrics over HTTP on a local
+// port: generations and cells per second, histograms of the durations of
+// the phases, how much of the board changes, the memory of the boards and
+// the process, and how busy each thread is.
+//
+// It is fed by the thread running the generations, between them, with the
+// phases it collected (see collect_phases()); the threads computing cells
+// only ever record phases, which doesn't lock.
+class MetricsServer {
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Histogram {
+            std::array<uint64_t, METRICS_BUCKETS> counts {};
+            uint64_t count = 0;
+            double sum_seconds = 0;
+        };
+
+        int fd = -1;
+        int port = 0;
+        std::thread thread;
+        std::atomic<bool> stopping { false };
+
+        // everything below is guarded by the mutex, taken by the feeding
+        // thread and the server thread
+        std::mutex mutex;
+        std::string family;
+        std::string rule;
+        int threads = 0;
+        int rows = 0;
+        int cols = 0;
+
+        uint64_t generations = 0;
+        uint64_t cells = 0;
+        double dirty_fraction = 0;
+        uint64_t board_bytes = 0;
+        // keyed by the phase names, which are string literals
+        std::map<std::string, Histogram> phases;
+        // time each thread spent in phases, by PhaseEvent::thread
+        std::vector<double> busy_seconds;
+
+        // the rates, and the figures they were last measured from
+        bool rate_started = false;
+        Clock::time_point rate_time;
+        uint64_t rate_generations = 0;
+        uint64_t rate_cells = 0;
+        std::vector<double> rate_busy_seconds;
+        double generations_per_second = 0;
+        double cells_per_second = 0;
+        std::vector<double> utilization;
+
+        void serve();
+        void respond(int client);
+        std::string render();
+
+    public:
+        MetricsServer() = default;
+        ~MetricsServer();
+        MetricsServer(const MetricsServer&) = delete;
+        MetricsServer& operator=(const MetricsServer&) = delete;
+
+        // Listens on 127.0.0.1:'port' (any free port for 0). Returns false
+        // with the reason in 'error' if it can't.
+        bool start(int port, std::string& error);
+        void stop();
+        bool is_running() const { return fd != -1; }
+        int get_port() const { return port; }
+
+        // what is being run, for the tomato_info metric
+        void set_run(const std::string& family, const std::string& rule,
+                     int threads, int rows, int cols);
+        // Adds the phases collected since the last call. Only one thread
+        // may feed the server.
+        void add_phases(const std::vector<PhaseEvent>& events);
+        // The run so far: generations, cells rewritten, the fraction of
+        // the board in the bounding box of the cells the last generation
+        // changed, and the bytes of the boards.
+        void set_progress(uint64_t generations, uint64_t cells,
+                          double dirty_fraction, uint64_t board_bytes);
+};
+
+#endif
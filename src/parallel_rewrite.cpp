@@ -0,0 +1,44 @@
+#include "./parallel_rewrite.h"
+
+void ParallelRewriter::rewrite(
+    CellularAutomata& automata, const Board& board, Board& board_copy,
+    StepContext& context
+) {
+    int bands = std::min(board.rows, pool.size() * BANDS_PER_THREAD);
+    if (pool.size() == 1 || bands <= 1 || !automata.can_rewrite_rows()) {
+        automata.rewrite(board, board_copy, context);
+        return;
+    }
+
+    StepContext band_context;
+    band_context.palette = context.palette;
+    band_context.pixels = context.pixels;
+    band_contexts.assign(bands, band_context);
+    if (context.stats != nullptr) {
+        // each band counts on its own, and they're added up after
+        band_stats.assign(bands, StepStats());
+        for (int band = 0; band < bands; band++) {
+            band_contexts[band].stats = &band_stats[band];
+        }
+    }
+
+    auto rewrite_band = [&](int band) {
+        automata.rewrite_rows(
+            board, board_copy, band_contexts[band],
+            band * board.rows / bands, (band + 1) * board.rows / bands
+        );
+    };
+    pool.run(bands, rewrite_band);
+
+    bool pixels_complete = true;
+    for (const StepContext& band : band_contexts) {
+        context.dirty.include(band.dirty);
+        pixels_complete &= band.pixels_complete;
+    }
+    context.pixels_complete = pixels_complete;
+    if (context.stats != nullptr) {
+        for (const StepStats& stats : band_stats) {
+            context.stats->add(stats);
+        }
+    }
+}
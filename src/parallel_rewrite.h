@@ -0,0 +1,38 @@
+#ifndef PARALLEL_REWRITE_H
+#define PARALLEL_REWRITE_H
+
+#include <vector>
+
+#include "./common.h"
+#include "./thread_pool.h"
+
+// each thread gets this many bands of rows per generation, so that a band
+// that happens to be slow doesn't hold up the others for long
+#define BANDS_PER_THREAD 4
+
+// Rewrites boards with the rows split into bands that are computed on a
+// pool of threads. Rule sets that can only be rewritten as a whole are
+// rewritten on the calling thread.
+class ParallelRewriter {
+    private:
+        ThreadPool pool;
+        // kept between generations so that rewriting doesn't allocate
+        std::vector<StepContext> band_contexts;
+        std::vector<StepStats> band_stats;
+
+    public:
+        explicit ParallelRewriter(int threads): pool(threads) {}
+
+        int threads() const { return pool.size(); }
+        // for other work split in bands between generations, like filling
+        // random boards
+        ThreadPool& thread_pool() { return pool; }
+
+        // same as automata.rewrite(board, board_copy, context)
+        void rewrite(
+            CellularAutomata& automata, const Board& board, Board& board_copy,
+            StepContext& context
+        );
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+
+#include "./perf_counters.h"
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+
+// the perf event of each PerfCounter
+static const std::array<std::pair<uint32_t, uint64_t>, PERF_COUNTERS_MAX>
+counter_events {{
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D
+        | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+        | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL
+        | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+        | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+}};
+
+// Each counter is opened on its own rather than as a group, since the
+// kernel doesn't read groups of inherited counters.
+PerfCounters::PerfCounters() {
+    for (int i = 0; i < PERF_COUNTERS_MAX; i++) {
+        perf_event_attr attributes;
+        memset(&attributes, 0, sizeof(attributes));
+        attributes.size = sizeof(attributes);
+        attributes.type = counter_events[i].first;
+        attributes.config = counter_events[i].second;
+        attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED
+            | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        attributes.inherit = 1;
+        attributes.exclude_kernel = 1;
+        attributes.exclude_hv = 1;
+
+        // this thread, on any CPU
+        fds[i] = syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0);
+        if (fds[i] == -1 && error.empty()) {
+            error = strerror(errno);
+        }
+    }
+}
+
+#else
+
+// other systems have no perf_event_open
+PerfCounters::PerfCounters() : error("not supported on this system") {
+    fds.fill(-1);
+}
+
+#endif
+
+PerfCounters::~PerfCounters() {
+    for (int fd : fds) {
+        if (fd != -1) {
+            close(fd);
+        }
+    }
+}
+
+bool PerfCounters::any_available() const {
+    for (int fd : fds) {
+        if (fd != -1) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// a count scaled up from the time running to the time enabled, or
+// nothing if the counter never got onto the CPU's counters
+static std::optional<uint64_t> scale(
+    uint64_t value, uint64_t enabled, uint64_t running
+) {
+    if (running == 0) {
+        return std::nullopt;
+    }
+    return running < enabled ?
+        static_cast<uint64_t>(static_cast<double>(value) * enabled / running) :
+        value;
+}
+
+PerfCounters::Sample PerfCounters::read() const {
+    Sample sample;
+    for (int i = 0; i < PERF_COUNTERS_MAX; i++) {
+        // value, time enabled, time running
+        std::array<uint64_t, 3>& values = sample.raw[i];
+        if (fds[i] == -1 ||
+            ::read(fds[i], values.data(), sizeof(values)) != sizeof(values)) {
+            values.fill(0);
+            continue;
+        }
+        sample.values[i] = scale(values[0], values[1], values[2]);
+    }
+    return sample;
+}
+
+// the raw counts and times only ever go up, but are clamped anyway
+static uint64_t increase(uint64_t start, uint64_t end) {
+    return end > start ? end - start : 0;
+}
+
+PerfCounters::Sample PerfCounters::difference(
+    const Sample& start, const Sample& end
+) {
+    Sample difference;
+    for (int i = 0; i < PERF_COUNTERS_MAX; i++) {
+        if (start.values[i].has_value() && end.values[i].has_value()) {
+            for (int j = 0; j < 3; j++) {
+                difference.raw[i][j] =
+                    increase(start.raw[i][j], end.raw[i][j]);
+            }
+            difference.values[i] = scale(
+                difference.raw[i][0], difference.raw[i][1],
+                difference.raw[i][2]
+            );
+        }
+    }
+    return difference;
+}
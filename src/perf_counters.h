@@ -0,0 +1,58 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+enum class PerfCounter {
+    Cycles,
+    Instructions,
+    L1DataMisses,
+    LastLevelMisses,
+    BranchMisses,
+};
+#define PERF_COUNTERS_MAX 5
+
+// Hardware counters of the calling thread and the threads it starts after
+// opening them, read through perf_event_open. Counters the kernel, CPU or
+// container doesn't allow (e.g. with perf_event_paranoid set high) are
+// simply missing.
+class PerfCounters {
+    public:
+        struct Sample {
+            std::array<std::optional<uint64_t>, PERF_COUNTERS_MAX> values;
+            // the count, time enabled and time running of each counter as
+            // read, before scaling
+            std::array<std::array<uint64_t, 3>, PERF_COUNTERS_MAX> raw {};
+
+            std::optional<uint64_t> operator[](PerfCounter counter) const {
+                return values[static_cast<int>(counter)];
+            }
+        };
+
+    private:
+        std::array<int, PERF_COUNTERS_MAX> fds;
+        // why the first counter that couldn't be opened wasn't
+        std::string error;
+
+    public:
+        PerfCounters();
+        ~PerfCounters();
+        PerfCounters(const PerfCounters&) = delete;
+        PerfCounters& operator=(const PerfCounters&) = delete;
+
+        bool any_available() const;
+        const std::string& get_error() const { return error; }
+
+        // the counts so far, scaled up for the time a counter wasn't
+        // running when the CPU has fewer counters than were asked for
+        Sample read() const;
+        // The counts between two samples, where both have them. The raw
+        // counts and times are differenced and then scaled, since the
+        // scaled estimates of two reads can go down between them.
+        static Sample difference(const Sample& start, const Sample& end);
+};
+
+#endif
@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+
+#include "./phase_timer.h"
+#include "./spsc_queue.h"
+
+std::atomic<bool> phase_timing_enabled { false };
+
+// The phases recorded by one thread, or on one track. It is kept alive by
+// the list of buffers after the thread exits, until its last phases are
+// collected; the thread number is then given to the next new thread.
+struct ThreadPhases {
+    int thread;
+    // set once the thread has exited and won't record any more
+    std::atomic<bool> finished { false };
+    SpscQueue<PhaseEvent, PHASE_BUFFER_SIZE> events;
+};
+
+// marks the buffer of a thread finished when the thread exits
+struct ThreadPhasesHolder {
+    std::shared_ptr<ThreadPhases> phases;
+
+    ~ThreadPhasesHolder() {
+        if (phases != nullptr) {
+            phases->finished = true;
+        }
+    }
+};
+
+static const std::chrono::steady_clock::time_point clock_start =
+    std::chrono::steady_clock::now();
+
+// the mutex guards the list and the thread names; it is only taken when a
+// thread records its first phase, when recording on a track and when
+// collecting
+static std::mutex threads_mutex;
+// by thread number, null for numbers free for the next new thread
+static std::vector<std::shared_ptr<ThreadPhases>> threads;
+// by thread number, of the last thread given it
+static std::vector<std::string> thread_names;
+static thread_local ThreadPhasesHolder this_thread_phases;
+// the name given before the thread recorded anything
+static thread_local std::string this_thread_name;
+static std::atomic<uint64_t> dropped { 0 };
+
+// adds a buffer under the first free thread number (with the lock held)
+static std::shared_ptr<ThreadPhases> add_thread_phases(
+    const std::string& name
+) {
+    auto phases = std::make_shared<ThreadPhases>();
+    auto free = std::find(threads.begin(), threads.end(), nullptr);
+    phases->thread = free - threads.begin();
+    if (free == threads.end()) {
+        threads.push_back(nullptr);
+        thread_names.emplace_back();
+    }
+    threads[phases->thread] = phases;
+    thread_names[phases->thread] = !name.empty() ?
+        name : "thread " + std::to_string(phases->thread);
+    return phases;
+}
+
+static ThreadPhases& get_thread_phases() {
+    std::shared_ptr<ThreadPhases>& phases = this_thread_phases.phases;
+    if (phases == nullptr) {
+        std::lock_guard<std::mutex> lock(threads_mutex);
+        phases = add_thread_phases(this_thread_name);
+    }
+    return *phases;
+}
+
+void set_phase_timing(bool enabled) {
+    phase_timing_enabled = enabled;
+}
+
+// threads that never record a phase don't need a buffer
+void name_phase_thread(const std::string& name) {
+    this_thread_name = name;
+    if (this_thread_phases.phases != nullptr) {
+        std::lock_guard<std::mutex> lock(threads_mutex);
+        thread_names[this_thread_phases.phases->thread] = name;
+    }
+}
+
+int add_phase_track(const std::string& name) {
+    std::lock_guard<std::mutex> lock(threads_mutex);
+    return add_thread_phases(name)->thread;
+}
+
+void record_phase(
+    int track, const char* name, uint64_t start_ns, uint64_t end_ns
+) {
+    std::shared_ptr<ThreadPhases> phases;
+    {
+        std::lock_guard<std::mutex> lock(threads_mutex);
+        phases = threads[track];
+    }
+    if (!phases->events.push({ name, track, start_ns, end_ns })) {
+        dropped++;
+    }
+}
+
+uint64_t phase_clock_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - clock_start
+    ).count();
+}
+
+void record_phase(const char* name, uint64_t start_ns, uint64_t end_ns) {
+    ThreadPhases& phases = get_thread_phases();
+    if (!phases.events.push({ name, phases.thread, start_ns, end_ns })) {
+        dropped++;
+    }
+}
+
+void collect_phases(std::vector<PhaseEvent>& events) {
+    std::vector<std::shared_ptr<ThreadPhases>> collected;
+    {
+        std::lock_guard<std::mutex> lock(threads_mutex);
+        collected = threads;
+    }
+    PhaseEvent event;
+    bool any_finished = false;
+    for (auto& phases : collected) {
+        if (phases == nullptr) {
+            continue;
+        }
+        // checked first, so that nothing can be recorded after the drain
+        bool finished = phases->finished;
+        while (phases->events.pop(event)) {
+            events.push_back(event);
+        }
+        if (finished) {
+            any_finished = true;
+        } else {
+            phases = nullptr;
+        }
+    }
+
+    // the buffers of threads that have exited are emptied now
+    if (any_finished) {
+        std::lock_guard<std::mutex> lock(threads_mutex);
+        for (auto& phases : collected) {
+            if (phases != nullptr) {
+                threads[phases->thread] = nullptr;
+            }
+        }
+    }
+}
+
+uint64_t dropped_phases() {
+    return dropped;
+}
+
+std::vector<std::string> phase_thread_names() {
+    std::lock_guard<std::mutex> lock(threads_mutex);
+    return thread_names;
+}
+
+void PhaseSummary::add(const std::vector<PhaseEvent>& events) {
+    for (const PhaseEvent& event : events) {
+        Window& window = windows[event.name];
+        double duration_ms = (event.end_ns - event.start_ns) / 1e6;
+        if (window.durations_ms.size() < PHASE_WINDOW) {
+            window.durations_ms.push_back(duration_ms);
+        } else {
+            window.durations_ms[window.next] = duration_ms;
+            window.next = (window.next + 1) % PHASE_WINDOW;
+        }
+    }
+}
+
+std::vector<PhaseSummary::Figures> PhaseSummary::figures() const {
+    std::vector<Figures> figures;
+    std::vector<double> sorted;
+    for (auto& entry : windows) {
+        sorted = entry.second.durations_ms;
+        std::sort(sorted.begin(), sorted.end());
+        double total = 0;
+        for (double duration : sorted) {
+            total += duration;
+        }
+        size_t p99 = (sorted.size() * 99 + 99) / 100 - 1;
+        figures.push_back({
+            entry.first, sorted.front(), total / sorted.size(),
+            sorted[sorted.size() / 2], sorted[p99]
+        });
+    }
+    return figures;
+}
+
+bool TraceCapture::start(const std::string& path, int frames) {
+    file = std::ofstream(path);
+    if (!file.is_open() || frames <= 0) {
+        frames_left = 0;
+        return false;
+    }
+    file << "{\"traceEvents\":[";
+    first_event = true;
+    frames_left = frames;
+    return true;
+}
+
+// complete events ("X") with microsecond times, which nest by time
+void TraceCapture::add(const std::vector<PhaseEvent>& events) {
+    if (!is_capturing()) {
+        return;
+    }
+    char times[64];
+    for (const PhaseEvent& event : events) {
+        snprintf(times, sizeof(times), "\"ts\":%.3f,\"dur\":%.3f",
+                 event.start_ns / 1e3, (event.end_ns - event.start_ns) / 1e3);
+        file << (first_event ? "\n" : ",\n") << "{\"name\":\"" << event.name
+             << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread << ","
+             << times << "}";
+        first_event = false;
+    }
+}
+
+void TraceCapture::end_frame() {
+    if (!is_capturing() || --frames_left > 0) {
+        return;
+    }
+    std::vector<std::string> names = phase_thread_names();
+    for (size_t thread = 0; thread < names.size(); thread++) {
+        file << (first_event ? "\n" : ",\n")
+             << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+             << thread << ",\"args\":{\"name\":\"" << names[thread] << "\"}}";
+        first_event = false;
+    }
+    file << "\n]}\n";
+    file.close();
+}
@@ -0,0 +1,120 @@
+#ifndef PHASE_TIMER_H
+#define PHASE_TIMER_H
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+// phases each thread can record before collect_phases() takes them; more
+// are dropped
+#define PHASE_BUFFER_SIZE 8192
+// phases of each name that the rolling figures are computed over
+#define PHASE_WINDOW 240
+
+// A phase some thread spent time in, in nanoseconds since the first phase
+// timer was used.
+struct PhaseEvent {
+    // a string literal, so the name can be kept without copying it
+    const char* name;
+    int thread;
+    uint64_t start_ns;
+    uint64_t end_ns;
+};
+
+extern std::atomic<bool> phase_timing_enabled;
+
+// Starts or stops the timing of phases. Timers cost a single load while
+// it is stopped.
+void set_phase_timing(bool enabled);
+// names the calling thread in traces, e.g. "simulation"
+void name_phase_thread(const std::string& name);
+void record_phase(const char* name, uint64_t start_ns, uint64_t end_ns);
+// Adds a track of its own to traces, for phases that overlap the ones of
+// the thread recording them (e.g. latencies spanning several frames).
+// Returns the track to record on; only one thread may record on it.
+int add_phase_track(const std::string& name);
+void record_phase(
+    int track, const char* name, uint64_t start_ns, uint64_t end_ns
+);
+uint64_t phase_clock_ns();
+// Moves the phases every thread recorded since the last call into
+// 'events', oldest first per thread. Only one thread may collect.
+void collect_phases(std::vector<PhaseEvent>& events);
+// phases dropped because a thread's buffer was full
+uint64_t dropped_phases();
+// Names of the threads that recorded phases, by PhaseEvent::thread. The
+// number of a thread that exited is given to the next new thread once its
+// phases are collected, and then takes its name.
+std::vector<std::string> phase_thread_names();
+
+// Times the scope it lives in as a phase called 'name', which must be a
+// string literal.
+class PhaseTimer {
+    private:
+        const char* name = nullptr;
+        uint64_t start_ns = 0;
+
+    public:
+        explicit PhaseTimer(const char* _name) {
+            if (phase_timing_enabled.load(std::memory_order_relaxed)) {
+                name = _name;
+                start_ns = phase_clock_ns();
+            }
+        }
+        ~PhaseTimer() {
+            if (name != nullptr) {
+                record_phase(name, start_ns, phase_clock_ns());
+            }
+        }
+        PhaseTimer(const PhaseTimer&) = delete;
+        PhaseTimer& operator=(const PhaseTimer&) = delete;
+};
+
+// Rolling minimum, average, median and 99th percentile of the duration of
+// each phase, over the last PHASE_WINDOW phases of each name.
+class PhaseSummary {
+    public:
+        struct Figures {
+            std::string name;
+            double min_ms;
+            double average_ms;
+            double p50_ms;
+            double p99_ms;
+        };
+
+        void add(const std::vector<PhaseEvent>& events);
+        // by name
+        std::vector<Figures> figures() const;
+
+    private:
+        struct Window {
+            std::vector<double> durations_ms;
+            // the oldest duration, once the window is full
+            size_t next = 0;
+        };
+        std::map<std::string, Window> windows;
+};
+
+// Writes the phases of a number of frames to a file in the Chrome trace
+// event format, for chrome://tracing or Perfetto.
+class TraceCapture {
+    private:
+        std::ofstream file;
+        int frames_left = 0;
+        bool first_event = true;
+
+    public:
+        // starts capturing into 'path'; returns false if it can't be opened
+        bool start(const std::string& path, int frames);
+        bool is_capturing() const { return frames_left > 0; }
+        int get_frames_left() const { return frames_left; }
+
+        void add(const std::vector<PhaseEvent>& events);
+        // counts a frame, and finishes the file after the last one
+        void end_frame();
+};
+
+#endif
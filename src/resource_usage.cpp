@@ -0,0 +1,66 @@
+#include <sys/resource.h>
+#include <fstream>
+
+#include "./resource_usage.h"
+
+// location of the package level RAPL domains
+#define POWERCAP_PATH "/sys/class/powercap/intel-rapl:"
+
+static double cpu_seconds() {
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec
+        + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+// the counters are usually only readable by root
+static bool read_counter(const std::string& path, uint64_t& value) {
+    std::ifstream file(path);
+    return static_cast<bool>(file >> value);
+}
+
+ResourceUsage::ResourceUsage() {
+    last_time = Clock::now();
+    last_cpu_seconds = cpu_seconds();
+
+    for (int package = 0;; package++) {
+        std::string domain = POWERCAP_PATH + std::to_string(package);
+        EnergyCounter counter { domain + "/energy_uj", 0, 0 };
+        if (!read_counter(domain + "/max_energy_range_uj",
+                          counter.max_energy_uj) ||
+            !read_counter(counter.path, counter.last_energy_uj)) {
+            break;
+        }
+        energy_counters.push_back(counter);
+    }
+}
+
+void ResourceUsage::sample() {
+    Clock::time_point now = Clock::now();
+    double elapsed = std::chrono::duration<double>(now - last_time).count();
+    if (elapsed < RESOURCE_SAMPLE_SECONDS) {
+        return;
+    }
+    last_time = now;
+
+    double cpu = cpu_seconds();
+    cpu_percent = (cpu - last_cpu_seconds) / elapsed * 100;
+    last_cpu_seconds = cpu;
+
+    uint64_t energy_uj = 0;
+    for (EnergyCounter& counter : energy_counters) {
+        uint64_t value;
+        if (!read_counter(counter.path, value)) {
+            continue;
+        }
+        if (value >= counter.last_energy_uj) {
+            energy_uj += value - counter.last_energy_uj;
+        } else {
+            energy_uj += counter.max_energy_uj - counter.last_energy_uj + value;
+        }
+        counter.last_energy_uj = value;
+    }
+    watts = energy_uj / 1e6 / elapsed;
+}
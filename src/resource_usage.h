@@ -0,0 +1,47 @@
+#ifndef RESOURCE_USAGE_H
+#define RESOURCE_USAGE_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// figures are averaged over at least this long
+#define RESOURCE_SAMPLE_SECONDS 1.0
+
+// Measures the CPU time used by this process, and the power drawn by the
+// CPU packages where the kernel exposes their energy counters (RAPL) to
+// this user.
+class ResourceUsage {
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct EnergyCounter {
+            std::string path;
+            // the counter wraps around after this many microjoules
+            uint64_t max_energy_uj;
+            uint64_t last_energy_uj;
+        };
+
+        Clock::time_point last_time;
+        double last_cpu_seconds = 0;
+        std::vector<EnergyCounter> energy_counters;
+
+        double cpu_percent = 0;
+        double watts = 0;
+
+    public:
+        ResourceUsage();
+
+        // updates the figures if RESOURCE_SAMPLE_SECONDS have passed since
+        // they were last updated
+        void sample();
+
+        // CPU time used per wall clock time, where 100 is one core
+        double get_cpu_percent() const { return cpu_percent; }
+        bool has_power() const { return !energy_counters.empty(); }
+        // power drawn by the CPU packages as a whole, not just this process
+        double get_watts() const { return watts; }
+};
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * Feeds malformed rule strings through the C interface, which must reject
+ * each with TOMATO_INVALID_RULE rather than accept a rule set that crashes
+ * when stepped. Written in C so that it also checks that tomato.h is.
+ */
+
+#include <stdio.h>
+
+#include "./tomato.h"
+
+struct rule {
+    const char* family;
+    const char* rules;
+};
+
+static const struct rule invalid_rules[] = {
+    /* transition tables shorter than states^5 */
+    { "NeumannBinary", "2" },
+    { "NeumannBinary", "20101" },
+    /* a transition to a state there is no row for */
+    { "RulesTable", "1,0,0,1,2" },
+    /* ranges past the neighbourhood offsets */
+    { "Cyclic", "R11/T3/C3/NM" },
+    { "Cyclic", "R0/T3/C3/NM" },
+    { "LargerThanLife", "R11,C0,M1,S34..58,B34..45,NM" },
+    { "LargerThanLife", "C0,M1,S34..58,B34..45,NM" },
+    /* state counts that don't fit in a cell */
+    { "Cyclic", "R1/T3/C300/NM" },
+    { "LargerThanLife", "R5,C300,M1,S34..58,B34..45,NM" },
+    { "Generations", "23/3/1" },
+    { "Generations", "23/3/300" },
+    { "WeightedLife", "NW1,NN1,NE1,WW1,EE1,SW1,SS1,SE1,HI300,RS2,RB3" },
+    /* counts the neighbourhood can't reach */
+    { "LargerThanLife", "R5,C0,M1,S0..255,B34..45,NM" },
+    { "Generations", "239/3/2" },
+};
+
+static const struct rule valid_rules[] = {
+    { "Life", "23/3" },
+    { "Generations", "012478/36/18" },
+    { "Cyclic", "R10/T3/C3/NM" },
+    { "LargerThanLife", "R5,C0,M1,S34..58,B34..45,NM" },
+    { "RulesTable", "1,0,0,0,0,1,1,0,0,0,0,0,0,0,0,1" },
+};
+
+int main(void) {
+    int failures = 0;
+    tomato_board* board = tomato_board_create(16, 16);
+    if (board == NULL) {
+        fprintf(stderr, "couldn't create a board: %s\n", tomato_last_error());
+        return 1;
+    }
+
+    for (size_t i = 0; i < sizeof(invalid_rules) / sizeof(*invalid_rules);
+         i++) {
+        const struct rule* rule = &invalid_rules[i];
+        tomato_status status =
+            tomato_select_rule_string(board, rule->family, rule->rules);
+        if (status != TOMATO_INVALID_RULE) {
+            fprintf(stderr, "%s \"%s\" was not rejected (status %d)\n",
+                    rule->family, rule->rules, status);
+            failures++;
+        }
+    }
+
+    for (size_t i = 0; i < sizeof(valid_rules) / sizeof(*valid_rules); i++) {
+        const struct rule* rule = &valid_rules[i];
+        if (tomato_select_rule_string(board, rule->family, rule->rules) !=
+                TOMATO_OK ||
+            tomato_randomize(board, i) != TOMATO_OK ||
+            tomato_step(board, 2) != TOMATO_OK) {
+            fprintf(stderr, "%s \"%s\" failed: %s\n", rule->family,
+                    rule->rules, tomato_last_error());
+            failures++;
+        }
+    }
+
+    tomato_board_destroy(board);
+    printf("%d failure(s)\n", failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#include "./sampling_profiler.h"
+
+// frames of the signal handler and the kernel's signal trampoline above
+// the interrupted function
+#define HANDLER_FRAMES 2
+
+// A stack taken by the signal handler. The slots form a bounded
+// multi-producer queue (Dmitry Vyukov's), since signals land on any
+// thread; 'sequence' says whether a slot is free, full or being written.
+struct StackSample {
+    std::atomic<uint64_t> sequence;
+    int depth;
+    void* frames[PROFILE_MAX_DEPTH];
+};
+
+static StackSample sample_buffer[PROFILE_BUFFER_SIZE];
+static std::atomic<uint64_t> sample_tail { 0 };
+static uint64_t sample_head = 0;
+static std::atomic<uint64_t> dropped_samples { 0 };
+static std::atomic<SamplingProfiler*> active_profiler { nullptr };
+static struct sigaction previous_action;
+
+// Only async-signal-safe work here: backtrace() and atomics. backtrace()
+// is called once before the first signal, so that it has loaded the
+// unwinder by then rather than inside the handler.
+static void handle_sigprof(int, siginfo_t*, void*) {
+    int saved_errno = errno;
+    void* frames[PROFILE_MAX_DEPTH + HANDLER_FRAMES];
+    int depth = backtrace(frames, PROFILE_MAX_DEPTH + HANDLER_FRAMES);
+
+    uint64_t position = sample_tail.load(std::memory_order_relaxed);
+    StackSample* sample;
+    while (true) {
+        sample = &sample_buffer[position & (PROFILE_BUFFER_SIZE - 1)];
+        uint64_t sequence = sample->sequence.load(std::memory_order_acquire);
+        if (sequence == position) {
+            if (sample_tail.compare_exchange_weak(
+                    position, position + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (sequence < position) {
+            dropped_samples.fetch_add(1, std::memory_order_relaxed);
+            errno = saved_errno;
+            return;
+        } else {
+            position = sample_tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    sample->depth = std::max(depth - HANDLER_FRAMES, 0);
+    for (int i = 0; i < sample->depth; i++) {
+        sample->frames[i] = frames[i + HANDLER_FRAMES];
+    }
+    sample->sequence.store(position + 1, std::memory_order_release);
+    errno = saved_errno;
+}
+
+SamplingProfiler::~SamplingProfiler() {
+    stop();
+}
+
+bool SamplingProfiler::start() {
+    SamplingProfiler* none = nullptr;
+    if (!active_profiler.compare_exchange_strong(none, this)) {
+        return false;
+    }
+
+    void* warm_up[1];
+    backtrace(warm_up, 1);
+    sample_tail = 0;
+    sample_head = 0;
+    for (uint64_t i = 0; i < PROFILE_BUFFER_SIZE; i++) {
+        sample_buffer[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    struct sigaction action {};
+    action.sa_sigaction = handle_sigprof;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    itimerval timer {};
+    timer.it_interval.tv_usec = 1000000 / PROFILE_RATE_HZ;
+    timer.it_value = timer.it_interval;
+    if (sigaction(SIGPROF, &action, &previous_action) != 0) {
+        active_profiler = nullptr;
+        return false;
+    }
+    if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+        sigaction(SIGPROF, &previous_action, nullptr);
+        active_profiler = nullptr;
+        return false;
+    }
+
+    running = true;
+    thread = std::thread(&SamplingProfiler::run, this);
+    return true;
+}
+
+void SamplingProfiler::stop() {
+    if (!running) {
+        return;
+    }
+    itimerval timer {};
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    // ignoring the signal discards any that are still pending, which
+    // would otherwise end the process under the default action
+    struct sigaction ignore {};
+    ignore.sa_handler = SIG_IGN;
+    sigaction(SIGPROF, &ignore, nullptr);
+    sigaction(SIGPROF, &previous_action, nullptr);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+    wake_condition.notify_one();
+    thread.join();
+    drain();
+    active_profiler = nullptr;
+}
+
+// the drain thread: folds the waiting stacks every
+// PROFILE_DRAIN_INTERVAL_MS
+void SamplingProfiler::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        wake_condition.wait_for(
+            lock, std::chrono::milliseconds(PROFILE_DRAIN_INTERVAL_MS),
+            [this] { return !running; }
+        );
+        lock.unlock();
+        drain();
+        lock.lock();
+    }
+}
+
+void SamplingProfiler::drain() {
+    std::lock_guard<std::mutex> lock(mutex);
+    while (true) {
+        StackSample& sample =
+            sample_buffer[sample_head & (PROFILE_BUFFER_SIZE - 1)];
+        if (sample.sequence.load(std::memory_order_acquire) !=
+            sample_head + 1) {
+            break;
+        }
+        stacks[std::vector<void*>(
+            sample.frames, sample.frames + sample.depth
+        )]++;
+        samples++;
+        sample.sequence.store(
+            sample_head + PROFILE_BUFFER_SIZE, std::memory_order_release
+        );
+        sample_head++;
+    }
+}
+
+uint64_t SamplingProfiler::get_samples() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return samples;
+}
+
+uint64_t SamplingProfiler::get_dropped() {
+    return dropped_samples;
+}
+
+// Names the function containing 'address' without its parameters, or the
+// module it's in. Return addresses point after the call, so all frames but
+// the leaf are looked up a byte earlier.
+const std::string& SamplingProfiler::symbolize(void* address, bool leaf) {
+    auto found = symbols.find(address);
+    if (found != symbols.end()) {
+        return found->second;
+    }
+
+    std::string name = "[unknown]";
+    Dl_info info;
+    void* lookup = static_cast<char*>(address) - (leaf ? 0 : 1);
+    bool found_module = dladdr(lookup, &info) != 0;
+    if (found_module && info.dli_sname != nullptr) {
+        int status;
+        char* demangled = abi::__cxa_demangle(
+            info.dli_sname, nullptr, nullptr, &status
+        );
+        name = status == 0 ? demangled : info.dli_sname;
+        free(demangled);
+
+        // drop the parameter list, and any qualifiers after it
+        size_t end = name.find_last_of(')');
+        if (end != std::string::npos && name.find('(') != std::string::npos) {
+            int depth = 0;
+            for (size_t i = end + 1; i-- > 0;) {
+                depth += name[i] == ')' ? 1 : name[i] == '(' ? -1 : 0;
+                if (depth == 0) {
+                    name.erase(i);
+                    break;
+                }
+            }
+        }
+    } else if (found_module && info.dli_fname != nullptr) {
+        const char* module = strrchr(info.dli_fname, '/');
+        name = std::string("[") +
+            (module != nullptr ? module + 1 : info.dli_fname) + "]";
+    }
+    // ';' separates frames in the folded format
+    for (char& c : name) {
+        if (c == ';') {
+            c = ':';
+        }
+    }
+    return symbols.emplace(address, name).first->second;
+}
+
+bool SamplingProfiler::write_folded(const std::string& path) {
+    drain();
+    std::lock_guard<std::mutex> lock(mutex);
+
+    // stacks that only differ in addresses within the same functions are
+    // merged
+    std::map<std::string, uint64_t> folded;
+    for (auto& entry : stacks) {
+        const std::vector<void*>& frames = entry.first;
+        std::string line;
+        for (size_t i = frames.size(); i-- > 0;) {
+            line += symbolize(frames[i], i == 0);
+            if (i > 0) {
+                line += ';';
+            }
+        }
+        folded[line] += entry.second;
+    }
+
+    std::ofstream file(path);
+    for (auto& entry : folded) {
+        file << entry.first << " " << entry.second << "\n";
+    }
+    stacks.clear();
+    samples = 0;
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,66 @@
+#ifndef SAMPLING_PROFILER_H
+#define SAMPLING_PROFILER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// samples per second of CPU time used by the process (a prime, so the
+// samples don't fall into step with periodic work)
+#define PROFILE_RATE_HZ 997
+// frames kept of each stack, from the innermost
+#define PROFILE_MAX_DEPTH 48
+// stacks that can be waiting to be folded (a power of two)
+#define PROFILE_BUFFER_SIZE 4096
+// how often the waiting stacks are folded
+#define PROFILE_DRAIN_INTERVAL_MS 50
+
+// Samples the stacks of whichever threads of the process are using the
+// CPU, driven by SIGPROF from setitimer(ITIMER_PROF), and writes them in
+// the folded format flame graph tools read ("outer;inner;leaf count").
+//
+// Only one profiler can be running at a time, since the timer and the
+// signal belong to the process. Functions are named from the dynamic
+// symbol table, so executables need to be linked with their symbols
+// exported (-rdynamic).
+class SamplingProfiler {
+    private:
+        // counts of the stacks sampled so far, innermost frame first
+        std::map<std::vector<void*>, uint64_t> stacks;
+        std::map<void*, std::string> symbols;
+        uint64_t samples = 0;
+        std::mutex mutex;
+
+        std::thread thread;
+        std::condition_variable wake_condition;
+        bool running = false;
+
+        void run();
+        void drain();
+        const std::string& symbolize(void* address, bool leaf);
+
+    public:
+        ~SamplingProfiler();
+
+        // returns false if sampling can't start, e.g. because another
+        // profiler is running
+        bool start();
+        void stop();
+        bool is_running() const { return running; }
+
+        // stacks sampled since the counts were last written
+        uint64_t get_samples();
+        // stacks lost because they weren't folded in time
+        static uint64_t get_dropped();
+
+        // writes the stacks sampled since the last call to 'path' and
+        // forgets them; returns false if the file can't be written
+        bool write_folded(const std::string& path);
+};
+
+#endif
@@ -0,0 +1,59 @@
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#include "./scheduler.h"
+
+void StepScheduler::restart(Clock::time_point now) {
+    owed = 0;
+    last_time = now;
+}
+
+int StepScheduler::due(Clock::time_point now, double rate, double budget_ms) {
+    double elapsed = std::chrono::duration<double>(now - last_time).count();
+    last_time = now;
+    target_rate = rate;
+
+    int count;
+    if (rate > 0) {
+        owed += elapsed * rate;
+        owed = std::min(owed, std::max(1.0, rate * MAX_BACKLOG_SECONDS));
+        count = static_cast<int>(owed);
+    } else {
+        owed = 0;
+        count = budget_ms > 0 ? INT_MAX : 1;
+    }
+
+    if (count > 0 && budget_ms > 0) {
+        int fit = 1;
+        if (average_ms > 0) {
+            fit = std::max(1.0, std::floor(budget_ms / average_ms));
+        }
+        count = std::min(count, fit);
+    }
+
+    return count;
+}
+
+void StepScheduler::completed(int count) {
+    if (target_rate > 0) {
+        owed = std::max(0.0, owed - count);
+    }
+}
+
+void StepScheduler::record(double generation_ms) {
+    if (average_ms == 0) {
+        average_ms = generation_ms;
+    } else {
+        average_ms += GENERATION_COST_WEIGHT * (generation_ms - average_ms);
+    }
+}
+
+StepScheduler::Clock::time_point StepScheduler::next_due_time() const {
+    if (target_rate <= 0 || owed >= 1) {
+        return last_time;
+    }
+    return last_time + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>((1 - owed) / target_rate)
+    );
+}
@@ -0,0 +1,52 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <chrono>
+
+// the UI should stay above 60 frames per second while generations are
+// computed on the render thread
+#define FRAME_TIME_TARGET_MS 16.0
+// generations are always given at least this much of a frame
+#define MIN_FRAME_BUDGET_MS 1.0
+// generations owed beyond this many seconds worth are forgotten, so that a
+// slow rule set doesn't build up a backlog it can never catch up with
+#define MAX_BACKLOG_SECONDS 0.25
+// weight of the newest sample in the average cost of a generation
+#define GENERATION_COST_WEIGHT 0.1
+
+// Decides how many generations are computed at a time, either to reach a
+// target number of generations per second, or as many as fit in a time
+// budget. The cost of a generation is measured as it runs, so the number
+// adapts to the rule set and board size.
+class StepScheduler {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+    private:
+        // generations that are due but haven't been computed yet
+        double owed = 0;
+        Clock::time_point last_time;
+        double target_rate = 0;
+        double average_ms = 0;
+
+    public:
+        // forgets owed generations, e.g. after the simulation was paused
+        void restart(Clock::time_point now);
+
+        // Number of generations to compute now, at a target of 'rate'
+        // generations per second (or as many as possible when 0). With a
+        // positive budget, no more than are expected to fit in budget_ms
+        // are returned, and the rest stay owed. At least one generation is
+        // returned whenever one is due.
+        int due(Clock::time_point now, double rate, double budget_ms);
+        // 'count' of the generations returned by due() were computed
+        void completed(int count);
+        // records the time a generation took
+        void record(double generation_ms);
+
+        // when the next generation is due at the current target rate
+        Clock::time_point next_due_time() const;
+        double average_generation_ms() const { return average_ms; }
+};
+
+#endif
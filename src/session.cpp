@@ -0,0 +1,505 @@
+#include <iterator>
+#include <memory>
+#include <thread>
+
+#include "./session.h"
+#include "./automata/automata.h"
+
+#define SESSION_MAGIC "TMSN"
+// 2: the random boards are filled by fill_soup(), so sessions of version 1
+// don't replay
+#define SESSION_VERSION 2
+
+//
+// encoding
+//
+
+static void write_varint(std::ostream& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.put(static_cast<char>((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    out.put(static_cast<char>(value));
+}
+
+static void write_string(std::ostream& out, const std::string& value) {
+    write_varint(out, value.size());
+    out.write(value.data(), value.size());
+}
+
+static void write_checksum(std::ostream& out, uint64_t checksum) {
+    for (int i = 0; i < 8; i++) {
+        out.put(static_cast<char>(checksum >> (i * 8)));
+    }
+}
+
+// Reads the encoded values back from the whole file. Every read fails once
+// the data runs out.
+class SessionReader {
+    private:
+        const std::string& data;
+        size_t position = 0;
+
+    public:
+        explicit SessionReader(const std::string& data): data(data) {}
+
+        bool at_end() const { return position == data.size(); }
+
+        bool read_byte(uint8_t& value) {
+            if (position >= data.size()) {
+                return false;
+            }
+            value = static_cast<uint8_t>(data[position++]);
+            return true;
+        }
+
+        bool read_varint(uint64_t& value) {
+            value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                uint8_t byte;
+                if (!read_byte(byte)) {
+                    return false;
+                }
+                value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool read_int(int& value) {
+            uint64_t wide;
+            if (!read_varint(wide)) {
+                return false;
+            }
+            value = static_cast<int>(static_cast<uint32_t>(wide));
+            return true;
+        }
+
+        bool read_string(std::string& value) {
+            uint64_t size;
+            if (!read_varint(size) || size > data.size() - position) {
+                return false;
+            }
+            value = data.substr(position, size);
+            position += size;
+            return true;
+        }
+
+        bool read_checksum(uint64_t& checksum) {
+            checksum = 0;
+            for (int i = 0; i < 8; i++) {
+                uint8_t byte;
+                if (!read_byte(byte)) {
+                    return false;
+                }
+                checksum |= static_cast<uint64_t>(byte) << (i * 8);
+            }
+            return true;
+        }
+};
+
+//
+// recording
+//
+
+SessionRecorder::SessionRecorder(
+    const std::string& path, const SessionHeader& header,
+    const CellularAutomataMap& cellular_automata
+) : file(path, std::ios::binary), start_time(Clock::now()) {
+    for (auto& family : cellular_automata) {
+        for (CellularAutomata* automata : family.second) {
+            names[automata] = { family.first, automata->name };
+        }
+    }
+
+    file.write(SESSION_MAGIC, 4);
+    write_varint(file, SESSION_VERSION);
+    write_varint(file, header.seed);
+    write_string(file, header.family);
+    write_string(file, header.rule);
+    write_varint(file, header.rows);
+    write_varint(file, header.cols);
+}
+
+SessionRecorder::~SessionRecorder() {
+    file.flush();
+}
+
+// writes the type and time of a record; the caller holds the mutex
+void SessionRecorder::begin_record(SessionRecordType type) {
+    uint64_t time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        Clock::now() - start_time
+    ).count();
+    file.put(static_cast<char>(type));
+    write_varint(file, time_us - last_time_us);
+    last_time_us = time_us;
+}
+
+void SessionRecorder::command_applied(
+    const Command& command, uint64_t
+) {
+    std::lock_guard<std::mutex> lock(mutex);
+    begin_record(SessionRecordType::Command);
+    file.put(static_cast<char>(command.type));
+    switch (command.type) {
+        case CommandType::Paint: {
+            write_varint(file, static_cast<uint32_t>(command.from_row));
+            write_varint(file, static_cast<uint32_t>(command.from_col));
+            write_varint(file, static_cast<uint32_t>(command.row));
+            write_varint(file, static_cast<uint32_t>(command.col));
+            write_varint(file, static_cast<uint32_t>(command.brush_size));
+            write_varint(file, command.state);
+            write_varint(file, command.is_right_click ? 1 : 0);
+        } break;
+        case CommandType::SetRule: {
+            auto name = names.find(command.automata);
+            if (name != names.end()) {
+                write_string(file, name->second.first);
+                write_string(file, name->second.second);
+            } else {
+                write_string(file, "");
+                write_string(file, "");
+            }
+        } break;
+        case CommandType::Resize: {
+            write_varint(file, static_cast<uint32_t>(command.size));
+        } break;
+        case CommandType::Clear:
+        case CommandType::Randomize:
+        case CommandType::Step: {
+        } break;
+    }
+}
+
+void SessionRecorder::generation_published(const Frame& frame) {
+    // checksummed outside the lock, since it reads the whole board
+    bool checksummed = frame.generation % SESSION_CHECKSUM_INTERVAL == 0;
+    uint64_t checksum = checksummed ? board_checksum(frame.board) : 0;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    begin_record(SessionRecordType::Generation);
+    if (checksummed) {
+        begin_record(SessionRecordType::Checksum);
+        write_checksum(file, checksum);
+    }
+}
+
+void SessionRecorder::record_color_scheme(int color_scheme) {
+    std::lock_guard<std::mutex> lock(mutex);
+    begin_record(SessionRecordType::ColorScheme);
+    write_varint(file, color_scheme);
+}
+
+void SessionRecorder::finish(const Board& board) {
+    uint64_t checksum = board_checksum(board);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (finished) {
+        return;
+    }
+    begin_record(SessionRecordType::End);
+    write_checksum(file, checksum);
+    file.flush();
+    finished = true;
+}
+
+//
+// replaying
+//
+
+bool SessionReplay::load(
+    const std::string& path, const CellularAutomataMap& cellular_automata,
+    std::string& error
+) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        error = "couldn't open " + path;
+        return false;
+    }
+    std::string data(
+        (std::istreambuf_iterator<char>(file)),
+        std::istreambuf_iterator<char>()
+    );
+    SessionReader reader(data);
+
+    uint64_t version, seed;
+    if (data.compare(0, 4, SESSION_MAGIC) != 0) {
+        error = path + " isn't a recorded session";
+        return false;
+    }
+    for (int i = 0; i < 4; i++) {
+        uint8_t byte;
+        reader.read_byte(byte);
+    }
+    if (!reader.read_varint(version) || version != SESSION_VERSION) {
+        error = path + " is a session of another version";
+        return false;
+    }
+    if (!reader.read_varint(seed) ||
+        !reader.read_string(header.family) ||
+        !reader.read_string(header.rule) ||
+        !reader.read_int(header.rows) || !reader.read_int(header.cols) ||
+        header.rows <= 0 || header.cols <= 0) {
+        error = path + " has a broken header";
+        return false;
+    }
+    header.seed = static_cast<unsigned>(seed);
+    initial_automata = find_cellular_automata(
+        cellular_automata, header.family, header.rule
+    );
+    if (initial_automata == nullptr) {
+        error = "unknown rule set '" + header.family + ": " + header.rule +
+            "' in " + path;
+        return false;
+    }
+    automata = initial_automata;
+    family = header.family;
+
+    // a record cut short (e.g. by a crash while recording) ends the
+    // session early
+    SessionRecord record;
+    uint64_t generation = 0;
+    while (!reader.at_end() && !ended) {
+        uint8_t type;
+        uint64_t delta_us;
+        if (!reader.read_byte(type) || !reader.read_varint(delta_us)) {
+            break;
+        }
+        record = SessionRecord();
+        record.type = static_cast<SessionRecordType>(type);
+        record.time_us = (records.empty() ? 0 : records.back().time_us) +
+            delta_us;
+
+        bool complete = true;
+        switch (record.type) {
+            case SessionRecordType::Generation: {
+                generation++;
+            } break;
+            case SessionRecordType::Command: {
+                uint8_t command_type;
+                complete = reader.read_byte(command_type);
+                if (!complete) {
+                    break;
+                }
+                Command& command = record.command;
+                command.type = static_cast<CommandType>(command_type);
+                uint64_t state = 0;
+                uint64_t is_right_click = 0;
+                switch (command.type) {
+                    case CommandType::Paint: {
+                        complete = reader.read_int(command.from_row) &&
+                            reader.read_int(command.from_col) &&
+                            reader.read_int(command.row) &&
+                            reader.read_int(command.col) &&
+                            reader.read_int(command.brush_size) &&
+                            reader.read_varint(state) &&
+                            reader.read_varint(is_right_click);
+                        command.state = static_cast<uint8_t>(state);
+                        command.is_right_click = is_right_click != 0;
+                    } break;
+                    case CommandType::SetRule: {
+                        complete = reader.read_string(record.family) &&
+                            reader.read_string(record.rule);
+                        command.automata = find_cellular_automata(
+                            cellular_automata, record.family, record.rule
+                        );
+                        if (complete && command.automata == nullptr) {
+                            error = "unknown rule set '" + record.family +
+                                ": " + record.rule + "' in " + path;
+                            return false;
+                        }
+                    } break;
+                    case CommandType::Resize: {
+                        complete = reader.read_int(command.size);
+                        if (complete && command.size <= 0) {
+                            error = path + " has a broken resize";
+                            return false;
+                        }
+                    } break;
+                    case CommandType::Clear:
+                    case CommandType::Randomize: {
+                    } break;
+                    default: {
+                        error = path + " has an unknown command";
+                        return false;
+                    }
+                }
+            } break;
+            case SessionRecordType::Checksum: {
+                complete = reader.read_checksum(record.checksum);
+                checksums[generation] = record.checksum;
+            } break;
+            case SessionRecordType::ColorScheme: {
+                complete = reader.read_int(record.color_scheme);
+            } break;
+            case SessionRecordType::End: {
+                complete = reader.read_checksum(end_checksum);
+                ended = complete;
+            } break;
+            default: {
+                error = path + " has an unknown record";
+                return false;
+            }
+        }
+        if (!complete) {
+            break;
+        }
+        record.generation = generation;
+        records.push_back(record);
+    }
+    return true;
+}
+
+void SessionReplay::attach(Simulation& simulation) {
+    simulation.set_observer(this);
+    simulation.set_drop_overwritten(false);
+}
+
+void SessionReplay::advance(
+    Simulation& simulation, uint64_t time_us, size_t max_records
+) {
+    size_t taken = 0;
+    while (next < records.size() && taken < max_records &&
+           records[next].time_us <= time_us) {
+        const SessionRecord& record = records[next++];
+        taken++;
+        switch (record.type) {
+            case SessionRecordType::Generation: {
+                simulation.push({ CommandType::Step });
+                generations++;
+            } break;
+            case SessionRecordType::Command: {
+                simulation.push(record.command);
+                commands++;
+                if (record.command.type == CommandType::SetRule) {
+                    automata = record.command.automata;
+                    family = record.family;
+                }
+            } break;
+            case SessionRecordType::ColorScheme: {
+                color_scheme = record.color_scheme;
+            } break;
+            case SessionRecordType::Checksum:
+            case SessionRecordType::End: {
+            } break;
+        }
+    }
+}
+
+uint64_t SessionReplay::get_duration_us() const {
+    return records.empty() ? 0 : records.back().time_us;
+}
+
+bool SessionReplay::check_end(const Board& board) const {
+    return ended && board_checksum(board) == end_checksum;
+}
+
+void SessionReplay::command_applied(const Command&, uint64_t) {
+}
+
+void SessionReplay::generation_published(const Frame& frame) {
+    auto checksum = checksums.find(frame.generation);
+    if (checksum == checksums.end()) {
+        return;
+    }
+    checked++;
+    if (board_checksum(frame.board) != checksum->second &&
+        mismatches++ == 0) {
+        first_mismatch = frame.generation;
+    }
+}
+
+int replay_session(const std::string& path, std::ostream& out) {
+    init_neighbourhood_offsets();
+    CellularAutomataMap cellular_automata = load_cellular_automata();
+    auto delete_cellular_automata = [&cellular_automata]() {
+        for (auto& family : cellular_automata) {
+            for (CellularAutomata* automata : family.second) {
+                delete automata;
+            }
+        }
+    };
+
+    SessionReplay replay;
+    std::string error;
+    if (!replay.load(path, cellular_automata, error)) {
+        out << error << std::endl;
+        delete_cellular_automata();
+        return 1;
+    }
+    const SessionHeader& header = replay.get_header();
+
+    double seconds;
+    bool end_matches;
+    uint64_t final_generation;
+    {
+        // too large for the stack (it holds its queues inline)
+        auto simulation = std::make_unique<Simulation>(
+            replay.get_initial_cellular_automata(), header.rows, header.cols,
+            header.seed
+        );
+        replay.attach(*simulation);
+        simulation->start();
+
+        // the commands are pushed a queue at a time, so that they don't
+        // pile up in the simulation's overflow
+        auto start_time = std::chrono::steady_clock::now();
+        while (!replay.is_finished() || !simulation->is_idle()) {
+            uint64_t waiting = simulation->commands_waiting();
+            if (waiting < COMMAND_QUEUE_SIZE) {
+                replay.advance(
+                    *simulation, UINT64_MAX, COMMAND_QUEUE_SIZE - waiting
+                );
+            }
+            simulation->update(0);
+#ifndef TOMATO_SINGLE_THREADED
+            if (!simulation->is_idle()) {
+                std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+#endif
+        }
+        seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start_time
+        ).count();
+
+        simulation->stop();
+        simulation->update_frame();
+        end_matches = replay.check_end(simulation->frame().board);
+        final_generation = simulation->frame().generation;
+    }
+
+    uint64_t generations = replay.get_generations();
+    double rate = seconds > 0 ? generations / seconds : 0;
+    out << "session:           " << path << std::endl
+        << "started with:      " << header.family << ": " << header.rule
+        << ", " << header.rows << "x" << header.cols << ", seed "
+        << header.seed << std::endl
+        << "recorded:          " << generations << " generations and "
+        << replay.get_commands() << " commands in "
+        << replay.get_duration_us() / 1e6 << " s" << std::endl
+        << "replayed in:       " << seconds << " s (" << rate
+        << " generations/s)" << std::endl
+        << "checksums:         " << replay.get_checked() << " checked, "
+        << replay.get_mismatches() << " mismatched";
+    if (replay.get_mismatches() > 0) {
+        out << " (first at generation " << replay.get_first_mismatch()
+            << ")";
+    }
+    out << std::endl << "final board:       ";
+    if (!replay.has_end()) {
+        out << "not recorded (the session was cut short)";
+    } else if (end_matches) {
+        out << "matches, generation " << final_generation;
+    } else {
+        out << "DIFFERS, generation " << final_generation;
+    }
+    out << std::endl;
+
+    delete_cellular_automata();
+    int failures = static_cast<int>(replay.get_mismatches());
+    if (replay.has_end() && !end_matches) {
+        failures++;
+    }
+    return failures;
+}
@@ -0,0 +1,191 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "./common.h"
+#include "./simulation.h"
+
+// A session is everything that decides the boards of a run of the app: the
+// seed, rule set and size it started with, then every command the
+// simulation applied and every generation it computed, in order and timed.
+// Replaying it computes the same boards, which checksums recorded along
+// the way confirm, so a slow session can be rerun as a benchmark.
+//
+// The file is a header followed by records, each a type byte, the time in
+// microseconds since the previous record and the fields of its type.
+// Numbers are LEB128 varints and strings are a length and the bytes;
+// checksums are 8 bytes, little-endian.
+
+// a checksum of the board is recorded every this many generations
+#define SESSION_CHECKSUM_INTERVAL 64
+
+enum class SessionRecordType : uint8_t {
+    // the next generation was computed
+    Generation = 1,
+    // a command was applied
+    Command,
+    // the checksum of the newest generation
+    Checksum,
+    // the color scheme changed (only matters to the window)
+    ColorScheme,
+    // the session ended, with the checksum of the final board
+    End,
+};
+
+struct SessionHeader {
+    unsigned seed = 0;
+    std::string family;
+    std::string rule;
+    int rows = 0;
+    int cols = 0;
+};
+
+struct SessionRecord {
+    SessionRecordType type = SessionRecordType::Generation;
+    // since the session started
+    uint64_t time_us = 0;
+    // the newest generation when the record was written (the one computed,
+    // for Generation)
+    uint64_t generation = 0;
+    // Command; SetRule commands point into the registry the session was
+    // loaded with
+    Command command { CommandType::Step };
+    std::string family;
+    std::string rule;
+    // Checksum, End
+    uint64_t checksum = 0;
+    // ColorScheme
+    int color_scheme = 0;
+};
+
+// Writes a session to a file as the simulation runs it. Set it as the
+// simulation's observer; the window adds the rest.
+class SessionRecorder: public SimulationObserver {
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        std::ofstream file;
+        // records come from the simulation and the render thread
+        std::mutex mutex;
+        Clock::time_point start_time;
+        uint64_t last_time_us = 0;
+        bool finished = false;
+        // names of the rule sets, for SetRule commands
+        std::unordered_map<
+            const CellularAutomata*, std::pair<std::string, std::string>
+        > names;
+
+        void begin_record(SessionRecordType type);
+
+    public:
+        SessionRecorder(
+            const std::string& path, const SessionHeader& header,
+            const CellularAutomataMap& cellular_automata
+        );
+        ~SessionRecorder();
+
+        bool is_open() const { return file.is_open() && file.good(); }
+
+        void command_applied(
+            const Command& command, uint64_t generation
+        ) override;
+        void generation_published(const Frame& frame) override;
+
+        void record_color_scheme(int color_scheme);
+        // ends the session with the newest board, once the simulation has
+        // stopped
+        void finish(const Board& board);
+};
+
+// A recorded session, replayed into a simulation attached to it.
+class SessionReplay: public SimulationObserver {
+    private:
+        SessionHeader header;
+        std::vector<SessionRecord> records;
+        // next record to replay
+        size_t next = 0;
+        // recorded checksums by generation
+        std::unordered_map<uint64_t, uint64_t> checksums;
+        // whether the session has an End record, and its checksum
+        bool ended = false;
+        uint64_t end_checksum = 0;
+        CellularAutomata* initial_automata = nullptr;
+
+        // the rule set and color scheme as of the records replayed so far
+        CellularAutomata* automata = nullptr;
+        std::string family;
+        int color_scheme = 0;
+        uint64_t generations = 0;
+        uint64_t commands = 0;
+
+        // updated by the simulation thread
+        std::atomic<uint64_t> checked { 0 };
+        std::atomic<uint64_t> mismatches { 0 };
+        std::atomic<uint64_t> first_mismatch { 0 };
+
+    public:
+        // Reads the session at 'path', whose rule sets are looked up in
+        // 'cellular_automata'. Returns false with a message in 'error' if
+        // it can't.
+        bool load(
+            const std::string& path,
+            const CellularAutomataMap& cellular_automata, std::string& error
+        );
+
+        const SessionHeader& get_header() const { return header; }
+        // Has 'simulation', created from the header and not started yet,
+        // check the recorded checksums and apply every command replayed
+        // whatever the batches they arrive in.
+        void attach(Simulation& simulation);
+        // the rule set it starts with
+        CellularAutomata* get_initial_cellular_automata() const {
+            return initial_automata;
+        }
+
+        // Pushes to 'simulation' the steps and commands of the records up
+        // to 'time_us' into the session, but at most 'max_records' of
+        // them. The simulation has to stay paused meanwhile.
+        void advance(Simulation& simulation, uint64_t time_us,
+                     size_t max_records = SIZE_MAX);
+        bool is_finished() const { return next == records.size(); }
+
+        CellularAutomata* get_cellular_automata() const { return automata; }
+        const std::string& get_family() const { return family; }
+        int get_color_scheme() const { return color_scheme; }
+        uint64_t get_generations() const { return generations; }
+        uint64_t get_commands() const { return commands; }
+        // of the whole session
+        uint64_t get_duration_us() const;
+
+        uint64_t get_checked() const { return checked; }
+        uint64_t get_mismatches() const { return mismatches; }
+        // the first generation whose checksum differed, if any did
+        uint64_t get_first_mismatch() const { return first_mismatch; }
+        // whether the session recorded its final board
+        bool has_end() const { return ended; }
+        // whether 'board', once everything is replayed, is the final board
+        // recorded
+        bool check_end(const Board& board) const;
+
+        void command_applied(
+            const Command& command, uint64_t generation
+        ) override;
+        void generation_published(const Frame& frame) override;
+};
+
+// Replays the session at 'path' as fast as possible without a window and
+// reports the time it took and whether the boards matched. Returns the
+// number of mismatches (1 when the session can't be read).
+int replay_session(const std::string& path, std::ostream& out);
+
+#endif
@@ -0,0 +1,610 @@
+#include <algorithm>
+
+#include "./simulation.h"
+#include "./automata/automata.h"
+#include "./phase_timer.h"
+#include "./allocation_tracker.h"
+#include "./soup.h"
+
+Simulation::Simulation(
+    CellularAutomata* automata, int rows, int cols, unsigned seed
+) : automata(automata), random_generator(seed)
+{
+    Frame& frame = frames.write_slot();
+    frame.board = Board(rows, cols);
+    randomize(frame.board);
+    cycle_detector.reset(frame.board, 0, automata->state_hash());
+    frame.cycle = cycle_detector.get_cycle();
+    publish(DirtyRect::whole_board(frame.board), false);
+}
+
+Simulation::~Simulation() {
+    stop();
+}
+
+void Simulation::start() {
+#ifndef TOMATO_SINGLE_THREADED
+    if (!running) {
+        running = true;
+        thread = std::thread(&Simulation::run, this);
+    }
+#endif
+}
+
+void Simulation::stop() {
+    if (!running) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+        woken = true;
+    }
+    wake_condition.notify_one();
+    thread.join();
+}
+
+void Simulation::update(double other_work_ms) {
+    flush_overflow();
+#ifdef TOMATO_SINGLE_THREADED
+    double budget_ms = FRAME_TIME_TARGET_MS;
+    if (target_rate == 0) {
+        budget_ms = frame_budget_ms;
+    }
+    budget_ms = std::max(
+        std::min(budget_ms, FRAME_TIME_TARGET_MS - other_work_ms),
+        MIN_FRAME_BUDGET_MS
+    );
+    Clock::time_point deadline = Clock::now()
+        + std::chrono::duration_cast<Clock::duration>(
+            std::chrono::duration<double, std::milli>(budget_ms)
+        );
+
+    apply_commands(deadline);
+    run_generations(budget_ms, deadline);
+#else
+    (void)other_work_ms;
+#endif
+}
+
+void Simulation::push(const Command& command) {
+    commands_pushed++;
+    flush_overflow();
+    if (!overflow.empty() || !commands.push(command)) {
+        overflow.push_back(command);
+    }
+    wake();
+}
+
+// retries the commands that didn't fit in the queue, in order
+void Simulation::flush_overflow() {
+    size_t flushed = 0;
+    while (flushed < overflow.size() && commands.push(overflow[flushed])) {
+        flushed++;
+    }
+    if (flushed > 0) {
+        overflow.erase(overflow.begin(), overflow.begin() + flushed);
+        wake();
+    }
+}
+
+bool Simulation::is_idle() const {
+    if (!paused ||
+        commands_applied.load(std::memory_order_acquire) != commands_pushed) {
+        return false;
+    }
+#ifdef TOMATO_SINGLE_THREADED
+    // a step may still be computed over the next frames
+    return !generation_pending;
+#else
+    return true;
+#endif
+}
+
+void Simulation::set_paused(bool _paused) {
+    paused = _paused;
+    wake();
+}
+
+void Simulation::set_target_rate(double generations_per_second) {
+    target_rate = generations_per_second;
+    wake();
+}
+
+void Simulation::set_frame_budget(double budget_ms) {
+    frame_budget_ms = budget_ms;
+}
+
+void Simulation::set_palette(const std::array<uint32_t, 256>& palette) {
+    std::lock_guard<std::mutex> lock(palette_mutex);
+    new_palette = palette;
+    palette_version++;
+}
+
+// The simulation never touches the pixels of the last published frame,
+// which is the only one it may share with the renderer, so they can be
+// swapped out of it.
+bool Simulation::take_pixels(std::vector<uint32_t>& pixels) {
+    Frame& frame = frames.read_slot();
+    if (!frame.pixels_complete ||
+        frame.palette_version != palette_version.load() ||
+        frame.pixels.size() != pixels.size()) {
+        return false;
+    }
+    std::swap(frame.pixels, pixels);
+    return true;
+}
+
+// Wakes the simulation thread if it is sleeping, or about to. The fence
+// pairs with the one in run(): either this sees 'sleeping' set, or the
+// simulation thread sees the command or setting that was just changed.
+void Simulation::wake() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!sleeping.load(std::memory_order_relaxed)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        woken = true;
+    }
+    wake_condition.notify_one();
+}
+
+bool Simulation::should_wake() {
+    return woken || !commands.empty();
+}
+
+// the simulation thread: sleeps until a command arrives or the next
+// generation is due
+void Simulation::run() {
+    name_phase_thread("simulation");
+    std::unique_lock<std::mutex> lock(mutex);
+    while (running) {
+        sleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!should_wake()) {
+            if (paused) {
+                wake_condition.wait(lock, [this] { return should_wake(); });
+            } else {
+                wake_condition.wait_until(
+                    lock, scheduler.next_due_time(),
+                    [this] { return should_wake(); }
+                );
+            }
+        }
+        sleeping.store(false, std::memory_order_relaxed);
+        woken = false;
+        if (!running) {
+            break;
+        }
+
+        lock.unlock();
+        apply_commands(Clock::time_point::max());
+        run_generations(0, Clock::time_point::max());
+        lock.lock();
+    }
+}
+
+// Applies the queued commands to a copy of the newest board. Consecutive
+// edits are published together as one frame, while steps publish the
+// edits before them and then a frame of their own. Commands wait while a
+// generation is pending, including one started by a step here.
+void Simulation::apply_commands(Clock::time_point deadline) {
+    if (generation_pending) {
+        return;
+    }
+    PhaseTimer timer("commands");
+
+    Command command;
+    while (commands.pop(command)) {
+        applying.push_back(command);
+    }
+
+    // Drop edits that a later clear, randomization or resize overwrites
+    // before the next step anyway. Paints are only dropped when none of the
+    // rule sets they could be applied with keeps state of its own from
+    // clicks, which a clear or randomization wouldn't undo.
+    bool drop_paints = !automata->click_changes_state();
+    for (const Command& command : applying) {
+        if (command.type == CommandType::SetRule &&
+            command.automata->click_changes_state()) {
+            drop_paints = false;
+        }
+    }
+    bool overwritten = false;
+    size_t kept = applying.size();
+    for (size_t i = applying.size(); i-- > 0;) {
+        bool keep = true;
+        switch (applying[i].type) {
+            case CommandType::Paint: {
+                keep = !overwritten || !drop_paints;
+            } break;
+            case CommandType::Clear:
+            case CommandType::Randomize: {
+                keep = !overwritten;
+                overwritten = true;
+            } break;
+            case CommandType::Resize: {
+                overwritten = true;
+            } break;
+            case CommandType::Step: {
+                overwritten = false;
+            } break;
+            case CommandType::SetRule: {
+            } break;
+        }
+        if (keep || !drop_overwritten) {
+            applying[--kept] = applying[i];
+        }
+    }
+    // the first 'kept' commands are the ones dropped
+    uint64_t handled = kept;
+    applying.erase(applying.begin(), applying.begin() + kept);
+
+    bool editing = false;
+    // whether the edits need the board hashed from scratch
+    bool rehash = false;
+    DirtyRect changed;
+    InputStamp input;
+    size_t applied = 0;
+    while (applied < applying.size() && !generation_pending) {
+        const Command& command = applying[applied++];
+        if (command.type == CommandType::Step) {
+            if (editing) {
+                track_edits(changed, rehash);
+                publish(changed, false, input);
+                editing = false;
+            }
+            // as in run_generations(), only colorized if it fits
+            auto average_cost = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double, std::milli>(
+                    scheduler.average_generation_ms()
+                )
+            );
+            begin_generation(Clock::now() + average_cost <= deadline);
+            continue_generation(deadline);
+            continue;
+        }
+
+        Frame& frame = frames.write_slot();
+        if (!editing) {
+            const Frame& latest = frames.last_published();
+            frame.board = latest.board;
+            frame.generation = latest.generation;
+            changed = DirtyRect();
+            input = InputStamp();
+            editing = true;
+            rehash = false;
+        }
+        apply_command(command, frame.board, changed);
+        if (observer != nullptr) {
+            observer->command_applied(command, frame.generation);
+        }
+        if (command.input_ns != 0) {
+            input.include({ command.input_ns, phase_clock_ns() });
+        }
+        rehash |= command.type == CommandType::SetRule ||
+            command.type == CommandType::Resize;
+    }
+    if (editing) {
+        track_edits(changed, rehash);
+        publish(changed, false, input);
+    }
+
+    applying.erase(applying.begin(), applying.begin() + applied);
+
+    // the frames these commands produced are published by now
+    handled += applied;
+    commands_applied.fetch_add(handled, std::memory_order_release);
+}
+
+// Brings the cycle detector up to date with edits to the write slot, which
+// start its history over.
+void Simulation::track_edits(const DirtyRect& changed, bool rehash) {
+    const Frame& latest = frames.last_published();
+    Frame& frame = frames.write_slot();
+    if (rehash || frame.board.rows != latest.board.rows ||
+        frame.board.cols != latest.board.cols) {
+        cycle_detector.reset(
+            frame.board, frame.generation, automata->state_hash()
+        );
+    } else {
+        cycle_detector.edit(
+            latest.board, frame.board, changed, frame.generation,
+            automata->state_hash()
+        );
+    }
+    frame.cycle = cycle_detector.get_cycle();
+}
+
+void Simulation::apply_command(
+    const Command& command, Board& board, DirtyRect& changed
+) {
+    switch (command.type) {
+        case CommandType::Paint: {
+            paint(command, board, changed);
+        } break;
+        case CommandType::Clear: {
+            board.fill(0);
+            changed = DirtyRect::whole_board(board);
+        } break;
+        case CommandType::Randomize: {
+            randomize(board);
+            changed = DirtyRect::whole_board(board);
+        } break;
+        case CommandType::SetRule: {
+            automata = command.automata;
+        } break;
+        case CommandType::Resize: {
+            board = Board(command.size, command.size);
+            randomize(board);
+            changed = DirtyRect::whole_board(board);
+        } break;
+        case CommandType::Step: {
+        } break;
+    }
+}
+
+// paints every cell whose center is within brush_size-1 (and a half) cells
+// of the stroke, each exactly once
+void Simulation::paint(
+    const Command& command, Board& board, DirtyRect& changed
+) {
+    int radius = command.brush_size - 1;
+    int min_row = std::max(std::min(command.from_row, command.row) - radius, 0);
+    int max_row = std::min(
+        std::max(command.from_row, command.row) + radius, board.rows-1
+    );
+    int min_col = std::max(std::min(command.from_col, command.col) - radius, 0);
+    int max_col = std::min(
+        std::max(command.from_col, command.col) + radius, board.cols-1
+    );
+
+    double stroke_rows = command.row - command.from_row;
+    double stroke_cols = command.col - command.from_col;
+    double length_squared =
+        stroke_rows * stroke_rows + stroke_cols * stroke_cols;
+    double max_distance_squared = (radius + 0.5) * (radius + 0.5);
+
+    for (int row = min_row; row <= max_row; row++) {
+        for (int col = min_col; col <= max_col; col++) {
+            // the point of the stroke closest to the cell
+            double t = 0;
+            if (length_squared > 0) {
+                t = ((row - command.from_row) * stroke_rows +
+                     (col - command.from_col) * stroke_cols) / length_squared;
+                t = std::min(std::max(t, 0.0), 1.0);
+            }
+            double row_distance = command.from_row + t * stroke_rows - row;
+            double col_distance = command.from_col + t * stroke_cols - col;
+            if (row_distance * row_distance + col_distance * col_distance >
+                max_distance_squared) {
+                continue;
+            }
+
+            automata->handle_mouse_click(
+                board, command.state, row, col, command.is_right_click
+            );
+            changed.include(row, col);
+        }
+    }
+}
+
+void Simulation::randomize(Board& board) {
+    // don't randomize board for turmites
+    if (dynamic_cast<Turmite*>(automata) != nullptr) {
+        return;
+    }
+    uint64_t seed = random_generator();
+    seed = seed << 32 | random_generator();
+    if (fill_pool == nullptr && board.cells.size() >= SOUP_PARALLEL_CELLS) {
+        fill_pool = std::make_unique<ThreadPool>(
+            std::max(1u, std::thread::hardware_concurrency())
+        );
+    }
+    fill_soup(board, automata->num_states, seed, SoupOptions(),
+              fill_pool.get());
+}
+
+// Computes the generations that are due, stopping early once the deadline
+// has passed (if 'budget_ms' is positive). A generation that is still
+// pending at the deadline is continued by the next call. Only the
+// generation expected to be the last one is colorized.
+void Simulation::run_generations(
+    double budget_ms, Clock::time_point deadline
+) {
+    bool finished_pending = false;
+    if (generation_pending) {
+        if (!continue_generation(deadline)) {
+            return;
+        }
+        finished_pending = true;
+    }
+
+    if (paused) {
+        scheduler_running = false;
+        return;
+    }
+    Clock::time_point now = Clock::now();
+    if (!scheduler_running) {
+        scheduler.restart(now);
+        scheduler_running = true;
+    }
+
+    int count = scheduler.due(now, target_rate, budget_ms);
+    auto average_cost = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double, std::milli>(
+            scheduler.average_generation_ms()
+        )
+    );
+
+    // the generation finished above was one of those due
+    int done = finished_pending ? 1 : 0;
+    while (done < count && !paused) {
+        Clock::time_point start = Clock::now();
+        if (done > 0 && start >= deadline) {
+            break;
+        }
+
+        // colorizing generations aren't split over frames, so that the
+        // pixels never run ahead of the published board
+        bool last = done == count - 1 || start + 2 * average_cost >= deadline;
+        bool fits = start + average_cost <= deadline;
+        begin_generation(last && fits);
+        if (!continue_generation(deadline)) {
+            break;
+        }
+        done++;
+    }
+
+    scheduler.completed(done);
+    average_generation_ms = scheduler.average_generation_ms();
+}
+
+// starts computing the generation after the newest board into the write
+// slot
+void Simulation::begin_generation(bool colorize) {
+    const Frame& latest = frames.last_published();
+    Frame& frame = frames.write_slot();
+    if (frame.board.rows != latest.board.rows ||
+        frame.board.cols != latest.board.cols) {
+        frame.board = Board(latest.board.rows, latest.board.cols);
+    }
+
+    pending_context = StepContext();
+    if (colorize && palette_version.load(std::memory_order_relaxed) != 0) {
+        if (pixel_palette_version != palette_version.load()) {
+            std::lock_guard<std::mutex> lock(palette_mutex);
+            pixel_palette = new_palette;
+            pixel_palette_version = palette_version;
+        }
+        frame.pixels.resize(latest.board.cells.size());
+        frame.palette_version = pixel_palette_version;
+        pending_context.palette = pixel_palette.data();
+        pending_context.pixels = frame.pixels.data();
+    }
+    if (collect_stats) {
+        pending_stats = StepStats();
+        pending_context.stats = &pending_stats;
+    }
+    pending_pixels_complete = true;
+    pending_ms = 0;
+    next_row = 0;
+    generation_pending = true;
+}
+
+// Computes rows of the pending generation until it's done or the deadline
+// has passed, and publishes it once every row is done. Returns whether it
+// was finished.
+bool Simulation::continue_generation(Clock::time_point deadline) {
+    PhaseTimer timer("generation");
+    AllocationScope allocation_scope(AllocationPhase::Step);
+    const Frame& latest = frames.last_published();
+    Frame& frame = frames.write_slot();
+    int rows = latest.board.rows;
+    Clock::time_point start = Clock::now();
+
+    bool chunked = deadline != Clock::time_point::max() &&
+        pending_context.pixels == nullptr && automata->can_rewrite_rows();
+    if (!chunked) {
+        automata->rewrite(latest.board, frame.board, pending_context);
+        pending_pixels_complete = pending_context.pixels_complete;
+        next_row = rows;
+    }
+    while (next_row < rows) {
+        // enough rows for about GENERATION_CHUNK_MS, going by the average
+        // cost of a whole generation
+        int chunk_rows = rows;
+        double average_ms = scheduler.average_generation_ms();
+        if (average_ms > 0) {
+            chunk_rows = std::max(
+                1, static_cast<int>(rows * GENERATION_CHUNK_MS / average_ms)
+            );
+        }
+        int last_row = std::min(rows, next_row + chunk_rows);
+
+        automata->rewrite_rows(
+            latest.board, frame.board, pending_context, next_row, last_row
+        );
+        pending_pixels_complete &= pending_context.pixels_complete;
+        next_row = last_row;
+
+        if (next_row < rows && Clock::now() >= deadline) {
+            break;
+        }
+    }
+
+    pending_ms += std::chrono::duration<double, std::milli>(
+        Clock::now() - start
+    ).count();
+    if (next_row < rows) {
+        return false;
+    }
+
+    generation_pending = false;
+    scheduler.record(pending_ms);
+    frame.generation = latest.generation + 1;
+    bool cycle_found = cycle_detector.step(
+        latest.board, frame.board, pending_context.dirty, frame.generation,
+        automata->state_hash()
+    );
+    frame.cycle = cycle_detector.get_cycle();
+    publish(pending_context.dirty, pending_pixels_complete);
+    if (observer != nullptr) {
+        observer->generation_published(frames.last_published());
+    }
+
+    if (pending_context.stats != nullptr) {
+        GenerationStats record;
+        record.generation = frame.generation;
+        record.num_states = automata->num_states;
+        record.stats = pending_stats;
+        record.skipped = stats_skipped;
+        if (!stats_queue.push(record)) {
+            stats_dropped++;
+            stats_skipped++;
+        } else {
+            stats_skipped = 0;
+        }
+    }
+
+    if (!pending_context.change_made() || (cycle_found && pause_on_cycle)) {
+        paused = true;
+    }
+    return true;
+}
+
+void Simulation::publish(
+    const DirtyRect& changed, bool pixels_complete, const InputStamp& input
+) {
+    Frame& frame = frames.write_slot();
+    // unlike the changes, input is only carried over from a frame that
+    // hasn't been taken, so that the renderer measures it once
+    frame.input = input;
+    if (frames.last_unread()) {
+        frame.input.include(unconsumed_input);
+    }
+    unconsumed_input = frame.input;
+    frame.dirty = unconsumed;
+    frame.dirty.include(changed);
+    if (!frame.dirty.empty()) {
+        // changes carried over from before a resize may lie outside the
+        // board
+        frame.dirty.max_row = std::min(
+            frame.dirty.max_row, frame.board.rows-1
+        );
+        frame.dirty.max_col = std::min(
+            frame.dirty.max_col, frame.board.cols-1
+        );
+    }
+    frame.pixels_complete = pixels_complete;
+    DirtyRect total = frame.dirty;
+
+    // if the previous frame was never taken, its changes have to reach the
+    // renderer through the next one
+    if (frames.publish()) {
+        unconsumed = changed;
+    } else {
+        unconsumed = total;
+    }
+}
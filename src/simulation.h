@@ -0,0 +1,294 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "./common.h"
+#include "./triple_buffer.h"
+#include "./spsc_queue.h"
+#include "./scheduler.h"
+#include "./cycle_detector.h"
+#include "./stats_writer.h"
+#include "./thread_pool.h"
+
+// commands that can be waiting for the simulation at once before the UI has
+// to hold on to them itself
+#define COMMAND_QUEUE_SIZE 1024
+// a generation that doesn't fit in the frame budget is computed this many
+// milliseconds worth of rows at a time, checking the time in between
+#define GENERATION_CHUNK_MS 0.5
+
+// When the oldest input behind the edits in a frame arrived, and when the
+// simulation applied it, in phase_clock_ns() (both 0 when no input is).
+struct InputStamp {
+    uint64_t input_ns = 0;
+    uint64_t applied_ns = 0;
+
+    // keeps the older of the two inputs
+    void include(const InputStamp& other) {
+        if (other.input_ns != 0 &&
+            (input_ns == 0 || other.input_ns < input_ns)) {
+            *this = other;
+        }
+    }
+};
+
+// A board as published by the simulation.
+struct Frame {
+    Board board;
+    uint64_t generation = 0;
+    // cells changed since the last frame the renderer took
+    DirtyRect dirty;
+    // set when the generation that produced this frame also wrote every
+    // pixel of 'pixels', in the palette of 'palette_version'
+    bool pixels_complete = false;
+    // the board colorized while it was computed, only valid when
+    // pixels_complete is set (otherwise left over from an older frame)
+    std::vector<uint32_t> pixels;
+    uint64_t palette_version = 0;
+    // the cycle the board has been found in since it was last edited
+    Cycle cycle;
+    // the input that led to the edits since the last frame the renderer
+    // took, if any (rarely, one it already took)
+    InputStamp input;
+};
+
+enum class CommandType {
+    Paint,
+    Clear,
+    Randomize,
+    SetRule,
+    Resize,
+    Step,
+};
+
+// An edit requested by the UI, applied by the simulation between
+// generations.
+struct Command {
+    CommandType type;
+
+    // Paint: a stroke from (from_row, from_col) to (row, col), painting
+    // every cell within brush_size-1 cells of it
+    int from_row = 0;
+    int from_col = 0;
+    int row = 0;
+    int col = 0;
+    int brush_size = 1;
+    uint8_t state = 0;
+    bool is_right_click = false;
+    // when the input that led to the stroke arrived (phase_clock_ns()),
+    // or 0
+    uint64_t input_ns = 0;
+
+    // SetRule
+    CellularAutomata* automata = nullptr;
+
+    // Resize
+    int size = 0;
+};
+
+// Sees the commands the simulation applies and the generations it computes,
+// on the thread computing them (e.g. to record or check a session).
+class SimulationObserver {
+    public:
+        virtual ~SimulationObserver() {}
+        // 'command' (never a step) was applied to the newest board, of
+        // 'generation'
+        virtual void command_applied(
+            const Command& command, uint64_t generation
+        ) = 0;
+        // 'frame' holds a generation that was just published
+        virtual void generation_published(const Frame& frame) = 0;
+};
+
+// Computes generations, on a thread of its own unless built with
+// TOMATO_SINGLE_THREADED.
+//
+// Completed boards are published through a triple buffer, so the renderer
+// always draws the newest board without blocking and the simulation never
+// waits for the renderer. The UI never writes to a board directly: edits
+// are queued as commands and applied by the simulation between
+// generations.
+class Simulation {
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        TripleBuffer<Frame> frames;
+        // cells changed by frames that may not have reached the renderer
+        DirtyRect unconsumed;
+        // the input behind the last frame published
+        InputStamp unconsumed_input;
+
+        CellularAutomata* automata;
+        // seeds the random boards, one after the other
+        std::default_random_engine random_generator;
+        // fills large random boards, started with the first one
+        std::unique_ptr<ThreadPool> fill_pool;
+        SimulationObserver* observer = nullptr;
+
+        std::atomic<bool> paused { true };
+        // generations per second, or 0 for as many as possible
+        std::atomic<double> target_rate { 10 };
+        std::atomic<double> frame_budget_ms { FRAME_TIME_TARGET_MS };
+        std::atomic<double> average_generation_ms { 0 };
+        // pause when the board is found repeating an earlier generation
+        std::atomic<bool> pause_on_cycle { true };
+        CycleDetector cycle_detector;
+        StepScheduler scheduler;
+        bool scheduler_running = false;
+
+        // A generation being computed into the write slot. Generations too
+        // slow for a frame are computed a chunk of rows at a time over
+        // several frames; commands wait until the generation is finished.
+        bool generation_pending = false;
+        int next_row = 0;
+        StepContext pending_context;
+        bool pending_pixels_complete = false;
+        double pending_ms = 0;
+
+        // statistics of every generation, gathered by the rewrite while
+        // enabled and taken by the render thread
+        std::atomic<bool> collect_stats { false };
+        StepStats pending_stats;
+        SpscQueue<GenerationStats, STATS_QUEUE_SIZE> stats_queue;
+        std::atomic<uint64_t> stats_dropped { 0 };
+        // statistics dropped since the last ones queued
+        uint64_t stats_skipped = 0;
+
+        // Optional fused colorizing of displayed generations. The render
+        // thread sets the palette under the mutex and bumps the version;
+        // the simulation copies it before colorizing.
+        std::mutex palette_mutex;
+        std::array<uint32_t, 256> new_palette;
+        std::atomic<uint64_t> palette_version { 0 };
+        // the simulation's copy, and its version
+        std::array<uint32_t, 256> pixel_palette;
+        uint64_t pixel_palette_version = 0;
+
+        // Commands from the UI. The queue itself is lock-free; the mutex
+        // and condition variable are only used to wake the simulation
+        // thread when it's sleeping.
+        SpscQueue<Command, COMMAND_QUEUE_SIZE> commands;
+        // commands that didn't fit in the queue (owned by the UI thread)
+        std::vector<Command> overflow;
+        // commands taken from the queue (owned by the simulation)
+        std::vector<Command> applying;
+        // whether edits overwritten before the next step are dropped
+        bool drop_overwritten = true;
+        // commands pushed by the UI, and those the simulation is done with
+        uint64_t commands_pushed = 0;
+        std::atomic<uint64_t> commands_applied { 0 };
+        std::mutex mutex;
+        std::condition_variable wake_condition;
+        bool woken = false;
+        std::atomic<bool> sleeping { false };
+
+        std::thread thread;
+        bool running = false;
+
+        void run();
+        bool should_wake();
+        void wake();
+        void flush_overflow();
+        void apply_commands(Clock::time_point deadline);
+        void apply_command(const Command& command, Board& board,
+                           DirtyRect& changed);
+        void paint(const Command& command, Board& board, DirtyRect& changed);
+        void randomize(Board& board);
+        void run_generations(double budget_ms, Clock::time_point deadline);
+        void begin_generation(bool colorize);
+        bool continue_generation(Clock::time_point deadline);
+        void track_edits(const DirtyRect& changed, bool rehash);
+        void publish(const DirtyRect& changed, bool pixels_complete,
+                     const InputStamp& input = InputStamp());
+
+    public:
+        // 'seed' seeds the random boards, starting with the first one
+        Simulation(
+            CellularAutomata* automata, int rows, int cols,
+            unsigned seed = std::default_random_engine::default_seed
+        );
+        ~Simulation();
+
+        // only to be called before start()
+        void set_observer(SimulationObserver* _observer) {
+            observer = _observer;
+        }
+        // Applies every command, even edits a later one overwrites anyway
+        // (which may still change the state of rule sets like turmites).
+        // Only to be called before start().
+        void set_drop_overwritten(bool drop) { drop_overwritten = drop; }
+        void start();
+        void stop();
+        // Called by the render thread once per frame, with the time it
+        // spent on everything else that frame. Single-threaded builds
+        // compute their generations here, in whatever is left of the frame
+        // time target.
+        void update(double other_work_ms);
+
+        // queues a command; only to be called from the render thread
+        void push(const Command& command);
+
+        // commands pushed that the simulation isn't done with yet; only to
+        // be called from the render thread
+        uint64_t commands_waiting() const {
+            return commands_pushed -
+                commands_applied.load(std::memory_order_acquire);
+        }
+
+        bool is_paused() const { return paused; }
+        // Whether the newest frame will stay the newest until a command is
+        // pushed or the simulation is unpaused. Only to be called from the
+        // render thread.
+        bool is_idle() const;
+        void set_paused(bool paused);
+        // generations per second while running, or 0 for as many as
+        // possible
+        void set_target_rate(double generations_per_second);
+        // whether to pause once the board repeats an earlier generation
+        // (still lifes always pause)
+        void set_pause_on_cycle(bool pause) { pause_on_cycle = pause; }
+        // Time per frame that may be spent on generations running as fast
+        // as possible. Only used by single-threaded builds; otherwise the
+        // simulation thread simply never stops.
+        void set_frame_budget(double budget_ms);
+        // Gathers the statistics of every generation from now on, for
+        // pop_stats(). Costs a little on every cell while enabled.
+        void set_collect_stats(bool collect) { collect_stats = collect; }
+        // takes the oldest statistics not taken yet; only to be called from
+        // the render thread
+        bool pop_stats(GenerationStats& stats) {
+            return stats_queue.pop(stats);
+        }
+        // statistics lost because the render thread didn't take them in
+        // time
+        uint64_t get_stats_dropped() const { return stats_dropped; }
+        // measured cost of a generation, averaged over the last few
+        double get_average_generation_ms() const {
+            return average_generation_ms;
+        }
+
+        // Lets the generations that are about to be displayed colorize
+        // their cells with 'palette' while they are computed, into the
+        // pixels of their frame. Only to be called from the render thread.
+        void set_palette(const std::array<uint32_t, 256>& palette);
+        // Swaps 'pixels' with those of the frame taken by update_frame() if
+        // they are complete, in the last palette set and of the same size.
+        // Returns whether they were swapped.
+        bool take_pixels(std::vector<uint32_t>& pixels);
+
+        // reader side: takes the newest frame if there is one, which then
+        // stays valid until the next call
+        bool update_frame() { return frames.update(); }
+        const Frame& frame() const { return frames.read_slot(); }
+};
+
+#endif
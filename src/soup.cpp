@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+#include "./soup.h"
+
+// cells whose draws are hashed at once
+#define SOUP_CHUNK 256
+
+// A cell is in the state given by how many thresholds its 32-bit draw is
+// at least: thresholds[s] starts the draws of state s (thresholds[0] is 0,
+// and a state that can't occur starts where the next one does). The
+// thresholds past the last state are above every draw.
+struct Thresholds {
+    uint64_t thresholds[257];
+    // The state of the smallest draw with each top 16 bits, where the
+    // search for the state of a draw starts. Only the draws of the few
+    // prefixes a threshold falls in have to look further, so the search
+    // hardly ever branches differently from one cell to the next.
+    uint8_t first[1 << 16] {};
+
+    uint8_t state(uint32_t draw) const {
+        int state = first[draw >> 16];
+        while (thresholds[state + 1] <= draw) {
+            state++;
+        }
+        return state;
+    }
+};
+
+static uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
+// "lowbias32" integer hash by Chris Wellons
+static inline uint32_t hash(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352d;
+    x ^= x >> 15;
+    x *= 0x846ca68b;
+    x ^= x >> 16;
+    return x;
+}
+
+#if defined(__SSE2__)
+static inline __m128i multiply(__m128i a, __m128i b) {
+#if defined(__SSE4_1__)
+    return _mm_mullo_epi32(a, b);
+#else
+    // SSE2 only multiplies the even lanes
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(
+        _mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+        _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0))
+    );
+#endif
+}
+
+// hash() of four lanes
+static inline __m128i hash(__m128i x) {
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+    x = multiply(x, _mm_set1_epi32(0x7feb352d));
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 15));
+    x = multiply(x, _mm_set1_epi32(static_cast<int>(0x846ca68bu)));
+    x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+    return x;
+}
+#endif
+
+// the draws of the cells with the given indices
+static void draw(
+    const uint32_t* indices, uint32_t* draws, int count,
+    uint32_t key0, uint32_t key1
+) {
+    int i = 0;
+#if defined(__SSE2__)
+    __m128i key0_lanes = _mm_set1_epi32(static_cast<int>(key0));
+    __m128i key1_lanes = _mm_set1_epi32(static_cast<int>(key1));
+    for (; i + 4 <= count; i += 4) {
+        __m128i x = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(indices + i)
+        );
+        x = hash(_mm_add_epi32(hash(_mm_xor_si128(x, key0_lanes)),
+                               key1_lanes));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(draws + i), x);
+    }
+#endif
+    for (; i < count; i++) {
+        draws[i] = hash(hash(indices[i] ^ key0) + key1);
+    }
+}
+
+// the probability of each state
+static std::vector<double> state_probabilities(
+    uint8_t num_states, const SoupOptions& options, std::string& error
+) {
+    if (num_states == 0) {
+        error = "a rule set needs at least one state";
+        return {};
+    }
+    if (options.weights.size() > num_states) {
+        error = "there are more weights than the rule set has states";
+        return {};
+    }
+    std::vector<double> weights = options.weights;
+    if (weights.empty()) {
+        weights.assign(num_states, 1);
+    }
+    weights.resize(num_states, 0);
+    for (double weight : weights) {
+        if (!std::isfinite(weight) || weight < 0) {
+            error = "weights can't be negative or infinite";
+            return {};
+        }
+    }
+
+    bool has_density = options.density >= 0 && options.density <= 1;
+    if (options.density >= 0 && !has_density) {
+        error = "the density must be between 0 and 1";
+        return {};
+    }
+    double live_weight = 0;
+    for (int state = 1; state < num_states; state++) {
+        live_weight += weights[state];
+    }
+    std::vector<double> probabilities(num_states, 0);
+    if (has_density) {
+        if (options.density > 0 && live_weight == 0) {
+            error = "no state other than 0 can make up the density";
+            return {};
+        }
+        probabilities[0] = 1 - options.density;
+        for (int state = 1; state < num_states; state++) {
+            probabilities[state] =
+                options.density * weights[state] / live_weight;
+        }
+    } else {
+        double total = weights[0] + live_weight;
+        if (total == 0) {
+            error = "the weights of every state are 0";
+            return {};
+        }
+        for (int state = 0; state < num_states; state++) {
+            probabilities[state] = weights[state] / total;
+        }
+    }
+    return probabilities;
+}
+
+static Thresholds make_thresholds(
+    uint8_t num_states, const SoupOptions& options
+) {
+    std::string error;
+    std::vector<double> probabilities =
+        state_probabilities(num_states, options, error);
+    if (!error.empty()) {
+        throw new std::runtime_error(error);
+    }
+
+    Thresholds thresholds;
+    std::fill(std::begin(thresholds.thresholds),
+              std::end(thresholds.thresholds), UINT64_MAX);
+    thresholds.thresholds[0] = 0;
+    bool uniform = options.weights.empty() &&
+        !(options.density >= 0 && options.density <= 1);
+    double cumulative = 0;
+    for (int state = 1; state < num_states; state++) {
+        if (uniform) {
+            // exact, so that every state gets the same number of draws
+            // (give or take one)
+            thresholds.thresholds[state] =
+                ((uint64_t(state) << 32) + num_states - 1) / num_states;
+        } else {
+            cumulative += probabilities[state - 1];
+            thresholds.thresholds[state] = std::min<uint64_t>(
+                std::llround(cumulative * 4294967296.0), uint64_t(1) << 32
+            );
+            thresholds.thresholds[state] = std::max(
+                thresholds.thresholds[state], thresholds.thresholds[state - 1]
+            );
+        }
+    }
+    int state = 0;
+    for (int prefix = 0; prefix < (1 << 16); prefix++) {
+        uint64_t draw = uint64_t(prefix) << 16;
+        while (thresholds.thresholds[state + 1] <= draw) {
+            state++;
+        }
+        thresholds.first[prefix] = state;
+    }
+    return thresholds;
+}
+
+// The indices of the cells whose states cells (row, col) to (row, col +
+// count - 1) take: the first cell of each one's orbit under the symmetry.
+static void source_indices(
+    SoupSymmetry symmetry, int rows, int cols, int row, int col, int count,
+    uint32_t* indices
+) {
+    uint32_t row_start = uint32_t(row) * cols;
+    uint32_t last_index = uint32_t(rows) * cols - 1;
+    uint32_t mirror_row_start = uint32_t(std::min(row, rows - 1 - row)) * cols;
+    switch (symmetry) {
+        case SoupSymmetry::None:
+            for (int i = 0; i < count; i++) {
+                indices[i] = row_start + col + i;
+            }
+            break;
+        case SoupSymmetry::MirrorColumns:
+        case SoupSymmetry::MirrorBoth: {
+            uint32_t start = symmetry == SoupSymmetry::MirrorBoth ?
+                mirror_row_start : row_start;
+            for (int i = 0; i < count; i++) {
+                indices[i] = start + std::min(col + i, cols - 1 - col - i);
+            }
+        } break;
+        case SoupSymmetry::MirrorRows:
+            for (int i = 0; i < count; i++) {
+                indices[i] = mirror_row_start + col + i;
+            }
+            break;
+        case SoupSymmetry::Rotate2:
+            for (int i = 0; i < count; i++) {
+                uint32_t index = row_start + col + i;
+                indices[i] = std::min(index, last_index - index);
+            }
+            break;
+        case SoupSymmetry::Rotate4: {
+            // rows == cols
+            int last = rows - 1;
+            for (int i = 0; i < count; i++) {
+                int c = col + i;
+                indices[i] = std::min({
+                    row_start + c,
+                    uint32_t(c) * cols + (last - row),
+                    uint32_t(last - row) * cols + (last - c),
+                    uint32_t(last - c) * cols + row,
+                });
+            }
+        } break;
+    }
+}
+
+static void fill_rows(
+    Board& board, const Thresholds& thresholds, SoupSymmetry symmetry,
+    uint32_t key0, uint32_t key1, int first_row, int last_row
+) {
+    uint32_t indices[SOUP_CHUNK];
+    uint32_t draws[SOUP_CHUNK];
+    for (int row = first_row; row < last_row; row++) {
+        uint8_t* cells = board[row];
+        for (int col = 0; col < board.cols; col += SOUP_CHUNK) {
+            int count = std::min(SOUP_CHUNK, board.cols - col);
+            source_indices(
+                symmetry, board.rows, board.cols, row, col, count, indices
+            );
+            draw(indices, draws, count, key0, key1);
+            for (int i = 0; i < count; i++) {
+                cells[col + i] = thresholds.state(draws[i]);
+            }
+        }
+    }
+}
+
+void fill_soup(
+    Board& board, uint8_t num_states, uint64_t seed,
+    const SoupOptions& options, ThreadPool* pool
+) {
+    Thresholds thresholds = make_thresholds(num_states, options);
+    SoupSymmetry symmetry = options.symmetry;
+    if (symmetry == SoupSymmetry::Rotate4 && board.rows != board.cols) {
+        symmetry = SoupSymmetry::Rotate2;
+    }
+    uint64_t key = splitmix64(seed);
+    uint32_t key0 = key;
+    uint32_t key1 = key >> 32;
+
+    int bands = 1;
+    if (pool != nullptr && board.cells.size() >= SOUP_PARALLEL_CELLS) {
+        bands = std::min(board.rows, pool->size() * SOUP_BANDS_PER_THREAD);
+    }
+    if (bands <= 1) {
+        fill_rows(board, thresholds, symmetry, key0, key1, 0, board.rows);
+        return;
+    }
+    auto fill_band = [&](int band) {
+        fill_rows(
+            board, thresholds, symmetry, key0, key1,
+            band * board.rows / bands, (band + 1) * board.rows / bands
+        );
+    };
+    pool->run(bands, fill_band);
+}
+
+bool check_soup_options(
+    uint8_t num_states, const SoupOptions& options, std::string& error
+) {
+    error.clear();
+    state_probabilities(num_states, options, error);
+    return error.empty();
+}
+
+static const std::pair<SoupSymmetry, const char*> symmetry_names[] = {
+    { SoupSymmetry::None, "none" },
+    { SoupSymmetry::MirrorColumns, "columns" },
+    { SoupSymmetry::MirrorRows, "rows" },
+    { SoupSymmetry::MirrorBoth, "both" },
+    { SoupSymmetry::Rotate2, "rotate2" },
+    { SoupSymmetry::Rotate4, "rotate4" },
+};
+
+bool parse_soup_symmetry(const std::string& name, SoupSymmetry& symmetry) {
+    for (const auto& symmetry_name : symmetry_names) {
+        if (name == symmetry_name.second) {
+            symmetry = symmetry_name.first;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char* soup_symmetry_name(SoupSymmetry symmetry) {
+    for (const auto& symmetry_name : symmetry_names) {
+        if (symmetry == symmetry_name.first) {
+            return symmetry_name.second;
+        }
+    }
+    return "none";
+}
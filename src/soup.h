@@ -0,0 +1,65 @@
+#ifndef SOUP_H
+#define SOUP_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "./common.h"
+#include "./thread_pool.h"
+
+// boards with fewer cells are filled on the calling thread
+#define SOUP_PARALLEL_CELLS (1 << 18)
+// each thread gets this many bands of rows to fill
+#define SOUP_BANDS_PER_THREAD 4
+
+// Mirror images of the cells a symmetric soup is made of. Every cell gets
+// the state of the first cell of its orbit, so the board is exactly
+// symmetric (about the middle of the board).
+enum class SoupSymmetry {
+    None,
+    // left and right halves mirror each other
+    MirrorColumns,
+    // top and bottom halves mirror each other
+    MirrorRows,
+    // both of the above
+    MirrorBoth,
+    // the same when rotated by a half turn
+    Rotate2,
+    // the same when rotated by a quarter turn; only square boards have
+    // this symmetry, so others get Rotate2
+    Rotate4,
+};
+
+struct SoupOptions {
+    // Relative weight of each state, by state. States past the end have a
+    // weight of 0, and no weights at all make every state equally likely.
+    std::vector<double> weights;
+    // If in [0, 1], the fraction of the cells in a state other than 0, the
+    // other states keeping their relative weights.
+    double density = -1;
+    SoupSymmetry symmetry = SoupSymmetry::None;
+};
+
+// Sets every cell to a random state below 'num_states'. The state of a cell
+// is a hash of its index and 'seed' (a counter-based generator), so the
+// board only depends on the seed and the options, never on the threads
+// filling it. Large boards are filled in bands of rows on 'pool' if given.
+// Throws if check_soup_options() fails.
+void fill_soup(
+    Board& board, uint8_t num_states, uint64_t seed,
+    const SoupOptions& options = SoupOptions(), ThreadPool* pool = nullptr
+);
+
+// Returns false, with the reason in 'error', for weights or a density that
+// don't make a distribution of the states.
+bool check_soup_options(
+    uint8_t num_states, const SoupOptions& options, std::string& error
+);
+
+// "none", "columns", "rows", "both", "rotate2" or "rotate4"; returns false
+// for anything else
+bool parse_soup_symmetry(const std::string& name, SoupSymmetry& symmetry);
+const char* soup_symmetry_name(SoupSymmetry symmetry);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+// Fixed size lock-free ring buffer passing values from one producer thread
+// to one consumer thread. Capacity must be a power of two.
+template<typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0,
+                  "SpscQueue capacity must be a power of two");
+
+    private:
+        std::array<T, Capacity> items;
+        // 'head' is only written by the consumer and 'tail' only by the
+        // producer; they are kept on separate cache lines so the two
+        // threads don't keep stealing the line from each other
+        alignas(64) std::atomic<size_t> head { 0 };
+        alignas(64) std::atomic<size_t> tail { 0 };
+
+    public:
+        // producer side: returns false (and drops nothing) when full
+        bool push(const T& item) {
+            size_t _tail = tail.load(std::memory_order_relaxed);
+            if (_tail - head.load(std::memory_order_acquire) == Capacity) {
+                return false;
+            }
+            items[_tail & (Capacity - 1)] = item;
+            tail.store(_tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // consumer side: returns false when empty
+        bool pop(T& item) {
+            size_t _head = head.load(std::memory_order_relaxed);
+            if (_head == tail.load(std::memory_order_acquire)) {
+                return false;
+            }
+            item = items[_head & (Capacity - 1)];
+            head.store(_head + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool empty() const {
+            return head.load(std::memory_order_acquire) ==
+                tail.load(std::memory_order_acquire);
+        }
+};
+
+#endif
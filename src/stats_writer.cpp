@@ -0,0 +1,124 @@
+#include <chrono>
+
+#include "./stats_writer.h"
+
+StatsWriter::StatsWriter(const std::string& path, int num_states)
+    : file(path), num_states(num_states)
+{
+    std::string extension = ".jsonl";
+    json_lines = path.size() >= extension.size() &&
+        path.compare(path.size() - extension.size(), extension.size(),
+                     extension) == 0;
+    if (!file.is_open()) {
+        return;
+    }
+    if (!json_lines) {
+        write_header();
+    }
+    thread = std::thread(&StatsWriter::run, this);
+}
+
+StatsWriter::~StatsWriter() {
+    if (!thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake_condition.notify_one();
+    thread.join();
+}
+
+// a dropped record is counted as skipped by the next one queued, along
+// with the generations it had skipped itself
+void StatsWriter::write(const GenerationStats& record) {
+    GenerationStats queued = record;
+    queued.skipped += skipped;
+    if (!is_open() || !queue.push(queued)) {
+        dropped++;
+        skipped = queued.skipped + 1;
+    } else {
+        skipped = 0;
+    }
+}
+
+void StatsWriter::write_all(const GenerationStats& record) {
+    if (!is_open()) {
+        dropped++;
+        return;
+    }
+    while (!queue.push(record)) {
+        std::this_thread::yield();
+    }
+}
+
+// the writer thread: drains the queue every STATS_WRITE_INTERVAL_MS, and
+// once more when stopping
+void StatsWriter::run() {
+    GenerationStats record;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        bool stop = stopping;
+        lock.unlock();
+        while (queue.pop(record)) {
+            write_record(record);
+        }
+        if (stop) {
+            break;
+        }
+        file.flush();
+        lock.lock();
+        wake_condition.wait_for(
+            lock, std::chrono::milliseconds(STATS_WRITE_INTERVAL_MS),
+            [this] { return stopping; }
+        );
+    }
+    file.flush();
+}
+
+void StatsWriter::write_header() {
+    file << "generation,skipped,births,deaths,"
+         << "live_min_row,live_min_col,live_max_row,live_max_col";
+    for (int state = 0; state < num_states; state++) {
+        file << ",state_" << state;
+    }
+    file << "\n";
+}
+
+// an empty bounding box is written as empty fields, or null
+void StatsWriter::write_record(const GenerationStats& record) {
+    const StepStats& stats = record.stats;
+    const DirtyRect& live = stats.live;
+    if (json_lines) {
+        file << "{\"generation\":" << record.generation
+             << ",\"skipped\":" << record.skipped
+             << ",\"births\":" << stats.births
+             << ",\"deaths\":" << stats.deaths << ",\"live\":";
+        if (live.empty()) {
+            file << "null";
+        } else {
+            file << "[" << live.min_row << "," << live.min_col << ","
+                 << live.max_row << "," << live.max_col << "]";
+        }
+        file << ",\"population\":[";
+        for (int state = 0; state < num_states; state++) {
+            file << (state > 0 ? "," : "") << stats.population[state];
+        }
+        file << "]}\n";
+        return;
+    }
+
+    file << record.generation << "," << record.skipped << ","
+         << stats.births << "," << stats.deaths << ",";
+    if (live.empty()) {
+        file << ",,,";
+    } else {
+        file << live.min_row << "," << live.min_col << ","
+             << live.max_row << "," << live.max_col;
+    }
+    for (int state = 0; state < num_states; state++) {
+        file << "," << stats.population[state];
+    }
+    file << "\n";
+}
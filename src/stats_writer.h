@@ -0,0 +1,73 @@
+#ifndef STATS_WRITER_H
+#define STATS_WRITER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "./common.h"
+#include "./spsc_queue.h"
+
+// generation statistics that can be waiting to be written (or drawn) at
+// once
+#define STATS_QUEUE_SIZE 4096
+// how often the writer thread looks for new statistics
+#define STATS_WRITE_INTERVAL_MS 50
+
+// The statistics of one generation, as recorded.
+struct GenerationStats {
+    uint64_t generation = 0;
+    // generations just before this one whose statistics were lost because
+    // a queue was full
+    uint64_t skipped = 0;
+    // states of the rule set the generation was computed with
+    int num_states = 0;
+    StepStats stats;
+};
+
+// Writes generation statistics to a file on a thread of its own, so the
+// thread computing generations never waits for the disk. Files ending in
+// .jsonl get a JSON object per line, anything else is written as CSV.
+class StatsWriter {
+    private:
+        SpscQueue<GenerationStats, STATS_QUEUE_SIZE> queue;
+        std::atomic<uint64_t> dropped { 0 };
+        // generations dropped since the last record queued, owned by the
+        // thread writing records
+        uint64_t skipped = 0;
+
+        std::ofstream file;
+        bool json_lines;
+        // states written per generation, as given to the constructor
+        int num_states;
+
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable wake_condition;
+        bool stopping = false;
+
+        void run();
+        void write_header();
+        void write_record(const GenerationStats& record);
+
+    public:
+        // starts writing to 'path', unless it can't be opened
+        StatsWriter(const std::string& path, int num_states);
+        // writes whatever is still queued, then closes the file
+        ~StatsWriter();
+
+        bool is_open() const { return file.is_open(); }
+
+        // queues a record without waiting; dropped if the queue is full
+        void write(const GenerationStats& record);
+        // queues a record, waiting for room in the queue if need be
+        void write_all(const GenerationStats& record);
+        // records that didn't fit in the queue
+        uint64_t get_dropped() const { return dropped; }
+};
+
+#endif
@@ -0,0 +1,82 @@
+#include "./thread_pool.h"
+#include "./phase_timer.h"
+
+ThreadPool::ThreadPool(int threads) {
+    for (int i = 1; i < threads; i++) {
+        workers.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    start_condition.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::work() {
+    name_phase_thread("worker");
+    uint64_t last_batch = 0;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        start_condition.wait(lock, [&] {
+            return stopping || batch != last_batch;
+        });
+        if (stopping) {
+            return;
+        }
+        last_batch = batch;
+
+        lock.unlock();
+        run_tasks();
+        lock.lock();
+
+        if (--working == 0) {
+            done_condition.notify_one();
+        }
+    }
+}
+
+// takes tasks of the current batch until there are none left
+void ThreadPool::run_tasks() {
+    AllocationScope allocation_scope(batch_phase);
+    int index;
+    while ((index = next_task.fetch_add(1)) < task_count) {
+        PhaseTimer timer("task");
+        invoke(task, index);
+    }
+}
+
+void ThreadPool::run_batch(
+    void* _task, void (*_invoke)(void*, int), int count
+) {
+    if (workers.empty() || count <= 1) {
+        for (int i = 0; i < count; i++) {
+            PhaseTimer timer("task");
+            _invoke(_task, i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = _task;
+        invoke = _invoke;
+        task_count = count;
+        next_task = 0;
+        batch_phase = current_allocation_phase();
+        working = workers.size();
+        batch++;
+    }
+    start_condition.notify_all();
+
+    run_tasks();
+
+    // the workers still read the batch until they are all done with it
+    std::unique_lock<std::mutex> lock(mutex);
+    done_condition.wait(lock, [this] { return working == 0; });
+}
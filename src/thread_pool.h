@@ -0,0 +1,58 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <cstdint>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "./allocation_tracker.h"
+
+// Runs batches of numbered tasks on a fixed set of worker threads. The
+// thread calling run() works on the batch too, so a pool of n threads only
+// starts n-1 workers.
+class ThreadPool {
+    private:
+        std::vector<std::thread> workers;
+
+        std::mutex mutex;
+        std::condition_variable start_condition;
+        std::condition_variable done_condition;
+        bool stopping = false;
+        // incremented for every batch, so workers can tell a new one apart
+        uint64_t batch = 0;
+        int working = 0;
+
+        // the current batch; the task is type erased without allocating
+        void* task = nullptr;
+        void (*invoke)(void* task, int index) = nullptr;
+        int task_count = 0;
+        std::atomic<int> next_task { 0 };
+        // of the thread that started the batch
+        AllocationPhase batch_phase = AllocationPhase::Other;
+
+        void work();
+        void run_tasks();
+        void run_batch(void* task, void (*invoke)(void*, int), int count);
+
+    public:
+        explicit ThreadPool(int threads);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        int size() const { return workers.size() + 1; }
+
+        // calls task(i) for every i in [0, count) and returns once all of
+        // them are done
+        template<typename F>
+        void run(int count, F& task) {
+            run_batch(&task, [](void* task, int index) {
+                (*static_cast<F*>(task))(index);
+            }, count);
+        }
+};
+
+#endif
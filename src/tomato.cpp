@@ -0,0 +1,351 @@
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#include "./tomato.h"
+#include "./common.h"
+#include "./parallel_rewrite.h"
+#include "./soup.h"
+#include "./automata/automata.h"
+
+struct tomato_board {
+    Board board;
+    Board board_copy;
+    uint64_t generation = 0;
+    DirtyRect changed;
+    double last_step_ms = 0;
+
+    // Rule sets selected by name come from a registry of the board's own,
+    // and those selected by rule string are owned by the board, so that
+    // boards never share the state of a rule set (e.g. the ants of a
+    // turmite).
+    CellularAutomataMap registry;
+    std::unique_ptr<CellularAutomata> owned_automata;
+    CellularAutomata* automata = nullptr;
+
+    std::unique_ptr<ParallelRewriter> rewriter;
+
+    tomato_board(int rows, int cols)
+        : board(rows, cols), board_copy(rows, cols),
+          rewriter(std::make_unique<ParallelRewriter>(1)) {}
+
+    ~tomato_board() {
+        for (auto& family : registry) {
+            for (CellularAutomata* automata : family.second) {
+                delete automata;
+            }
+        }
+    }
+};
+
+static thread_local std::string last_error;
+
+static tomato_status fail(tomato_status status, const std::string& message) {
+    last_error = message;
+    return status;
+}
+
+// the neighbourhood offsets are shared by every board
+static void init_engine() {
+    static std::once_flag initialized;
+    std::call_once(initialized, init_neighbourhood_offsets);
+}
+
+// the rule sets look their tables up by state, so states they don't have
+// can't be written while one is selected
+static bool valid_state(const tomato_board* board, uint8_t state) {
+    return board->automata == nullptr || state < board->automata->num_states;
+}
+
+// cells in states the newly selected rule set doesn't have are cleared
+static void select(tomato_board* board, CellularAutomata* automata) {
+    board->automata = automata;
+    for (uint8_t& cell : board->board.cells) {
+        if (cell >= automata->num_states) {
+            cell = 0;
+        }
+    }
+}
+
+static CellularAutomata* create_cellular_automata(
+    const std::string& family, const std::string& rules
+) {
+    if (family == "Life") {
+        return new Life(rules, rules);
+    } else if (family == "Generations") {
+        return new Generations(rules, rules);
+    } else if (family == "Cyclic") {
+        return new Cyclic(rules, rules);
+    } else if (family == "LargerThanLife") {
+        return new LargerThanLife(rules, rules);
+    } else if (family == "NeumannBinary") {
+        return new NeumannBinary(rules, rules);
+    } else if (family == "RulesTable") {
+        return new RulesTable(rules, rules);
+    } else if (family == "WeightedLife") {
+        return new WeightedLife(rules, rules);
+    } else if (family == "Ants") {
+        return new Turmite(rules, rules);
+    }
+    return nullptr;
+}
+
+extern "C" {
+
+int tomato_api_version(void) {
+    return TOMATO_API_VERSION;
+}
+
+const char* tomato_last_error(void) {
+    return last_error.c_str();
+}
+
+tomato_board* tomato_board_create(int rows, int cols) {
+    if (rows <= 0 || cols <= 0) {
+        fail(TOMATO_INVALID_ARGUMENT, "board size must be positive");
+        return nullptr;
+    }
+    // the cells are indexed by int
+    if (int64_t(rows) * cols > INT_MAX) {
+        fail(TOMATO_INVALID_ARGUMENT, "board too large");
+        return nullptr;
+    }
+    init_engine();
+    try {
+        return new tomato_board(rows, cols);
+    } catch (const std::bad_alloc&) {
+        fail(TOMATO_INVALID_ARGUMENT, "board too large");
+        return nullptr;
+    } catch (const std::exception& error) {
+        fail(TOMATO_FAILED, error.what());
+        return nullptr;
+    }
+}
+
+void tomato_board_destroy(tomato_board* board) {
+    delete board;
+}
+
+int tomato_board_rows(const tomato_board* board) {
+    return board->board.rows;
+}
+
+int tomato_board_cols(const tomato_board* board) {
+    return board->board.cols;
+}
+
+tomato_status tomato_select_rule(
+    tomato_board* board, const char* family, const char* name
+) {
+    CellularAutomata* automata;
+    try {
+        if (board->registry.empty()) {
+            board->registry = load_cellular_automata();
+        }
+        automata = find_cellular_automata(board->registry, family, name);
+    } catch (const std::exception& error) {
+        return fail(TOMATO_FAILED, error.what());
+    }
+    if (automata == nullptr) {
+        return fail(
+            TOMATO_UNKNOWN_RULE,
+            std::string("unknown rule set ") + family + ": " + name
+        );
+    }
+    select(board, automata);
+    board->owned_automata.reset();
+    return TOMATO_OK;
+}
+
+tomato_status tomato_select_rule_string(
+    tomato_board* board, const char* family, const char* rules
+) {
+    CellularAutomata* automata;
+    // the rule sets report bad rule strings by throwing pointers
+    try {
+        automata = create_cellular_automata(family, rules);
+    } catch (std::runtime_error* error) {
+        std::string message = error->what();
+        delete error;
+        return fail(TOMATO_INVALID_RULE, message);
+    } catch (const std::exception& error) {
+        return fail(TOMATO_INVALID_RULE, error.what());
+    } catch (...) {
+        return fail(TOMATO_INVALID_RULE, "invalid rule string");
+    }
+    if (automata == nullptr) {
+        return fail(
+            TOMATO_UNKNOWN_RULE, std::string("unknown family ") + family
+        );
+    }
+
+    board->owned_automata.reset(automata);
+    select(board, automata);
+    return TOMATO_OK;
+}
+
+tomato_status tomato_set_threads(tomato_board* board, int threads) {
+    if (threads <= 0) {
+        return fail(TOMATO_INVALID_ARGUMENT, "thread count must be positive");
+    }
+    if (threads != board->rewriter->threads()) {
+        try {
+            board->rewriter = std::make_unique<ParallelRewriter>(threads);
+        } catch (const std::exception& error) {
+            return fail(TOMATO_FAILED, error.what());
+        }
+    }
+    return TOMATO_OK;
+}
+
+tomato_status tomato_randomize(tomato_board* board, uint64_t seed) {
+    return tomato_randomize_soup(
+        board, seed, -1, nullptr, 0, TOMATO_SYMMETRY_NONE
+    );
+}
+
+tomato_status tomato_randomize_soup(
+    tomato_board* board, uint64_t seed, double density,
+    const double* weights, size_t weight_count, tomato_symmetry symmetry
+) {
+    if (board->automata == nullptr) {
+        return fail(TOMATO_NO_RULE, "no rule set selected");
+    }
+    int symmetry_index = symmetry;
+    if (symmetry_index < TOMATO_SYMMETRY_NONE ||
+        symmetry_index > TOMATO_SYMMETRY_ROTATE4) {
+        return fail(TOMATO_INVALID_ARGUMENT, "unknown symmetry");
+    }
+    try {
+        SoupOptions options;
+        if (weights != nullptr) {
+            options.weights.assign(weights, weights + weight_count);
+        }
+        options.density = density;
+        // the enums are in the same order
+        options.symmetry = static_cast<SoupSymmetry>(symmetry);
+
+        std::string error;
+        if (!check_soup_options(board->automata->num_states, options, error)) {
+            return fail(TOMATO_INVALID_ARGUMENT, error);
+        }
+        if (dynamic_cast<Turmite*>(board->automata) == nullptr) {
+            fill_soup(board->board, board->automata->num_states, seed,
+                      options, &board->rewriter->thread_pool());
+        }
+    } catch (const std::exception& error) {
+        return fail(TOMATO_FAILED, error.what());
+    }
+    return TOMATO_OK;
+}
+
+tomato_status tomato_step(tomato_board* board, int generations) {
+    if (board->automata == nullptr) {
+        return fail(TOMATO_NO_RULE, "no rule set selected");
+    }
+    if (generations < 0) {
+        return fail(
+            TOMATO_INVALID_ARGUMENT, "generation count must not be negative"
+        );
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    try {
+        for (int i = 0; i < generations; i++) {
+            StepContext context;
+            board->rewriter->rewrite(
+                *board->automata, board->board, board->board_copy, context
+            );
+            std::swap(board->board, board->board_copy);
+            board->changed = context.dirty;
+            board->generation++;
+        }
+    } catch (const std::exception& error) {
+        return fail(TOMATO_FAILED, error.what());
+    }
+    board->last_step_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start_time
+    ).count();
+    return TOMATO_OK;
+}
+
+tomato_status tomato_read_cells(
+    const tomato_board* board, uint8_t* cells, size_t count
+) {
+    if (count != board->board.cells.size()) {
+        return fail(TOMATO_INVALID_ARGUMENT, "count must be rows * cols");
+    }
+    memcpy(cells, board->board.cells.data(), count);
+    return TOMATO_OK;
+}
+
+tomato_status tomato_write_cells(
+    tomato_board* board, const uint8_t* cells, size_t count
+) {
+    if (count != board->board.cells.size()) {
+        return fail(TOMATO_INVALID_ARGUMENT, "count must be rows * cols");
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (!valid_state(board, cells[i])) {
+            return fail(TOMATO_INVALID_ARGUMENT, "state out of range");
+        }
+    }
+    memcpy(board->board.cells.data(), cells, count);
+    return TOMATO_OK;
+}
+
+tomato_status tomato_get_cell(
+    const tomato_board* board, int row, int col, uint8_t* state
+) {
+    if (!board->board.in_bounds(row, col)) {
+        return fail(TOMATO_INVALID_ARGUMENT, "cell out of bounds");
+    }
+    *state = board->board[row][col];
+    return TOMATO_OK;
+}
+
+tomato_status tomato_set_cell(
+    tomato_board* board, int row, int col, uint8_t state
+) {
+    if (!board->board.in_bounds(row, col)) {
+        return fail(TOMATO_INVALID_ARGUMENT, "cell out of bounds");
+    }
+    if (!valid_state(board, state)) {
+        return fail(TOMATO_INVALID_ARGUMENT, "state out of range");
+    }
+    board->board[row][col] = state;
+    return TOMATO_OK;
+}
+
+tomato_status tomato_get_stats(
+    const tomato_board* board, tomato_stats* stats
+) {
+    if (stats->size < sizeof(uint32_t)) {
+        return fail(TOMATO_INVALID_ARGUMENT, "stats size not set");
+    }
+
+    tomato_stats result;
+    result.size = stats->size;
+    result.generation = board->generation;
+    result.num_states =
+        board->automata != nullptr ? board->automata->num_states : 0;
+    result.population = 0;
+    for (uint8_t cell : board->board.cells) {
+        result.population += cell != 0;
+    }
+    result.checksum = board_checksum(board->board);
+    result.changed_min_row = board->changed.min_row;
+    result.changed_min_col = board->changed.min_col;
+    result.changed_max_row = board->changed.max_row;
+    result.changed_max_col = board->changed.max_col;
+    result.last_step_ms = board->last_step_ms;
+
+    memcpy(stats, &result, std::min<size_t>(stats->size, sizeof(result)));
+    return TOMATO_OK;
+}
+
+}
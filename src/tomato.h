@@ -0,0 +1,134 @@
+#ifndef TOMATO_H
+#define TOMATO_H
+
+/*
+ * C interface to the engine, for embedding it in other programs without the
+ * UI. Every function may be called from any thread, but a board must not be
+ * used by two threads at once.
+ *
+ * Functions returning a tomato_status set a message for the calling thread
+ * when they fail, which tomato_last_error() returns.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* incremented whenever the interface changes incompatibly */
+#define TOMATO_API_VERSION 1
+
+typedef struct tomato_board tomato_board;
+
+typedef enum tomato_status {
+    TOMATO_OK = 0,
+    TOMATO_INVALID_ARGUMENT,
+    TOMATO_UNKNOWN_RULE,
+    TOMATO_INVALID_RULE,
+    TOMATO_NO_RULE,
+    /* the engine failed, e.g. it ran out of memory or couldn't start its
+       threads */
+    TOMATO_FAILED,
+} tomato_status;
+
+typedef struct tomato_stats {
+    /* set by the caller to sizeof(tomato_stats); fields past it are left
+       alone, so that older callers keep working when fields are added */
+    uint32_t size;
+
+    uint64_t generation;
+    int32_t num_states;
+    /* cells in a state other than 0 */
+    uint64_t population;
+    /* FNV-1a hash of the board size and cells */
+    uint64_t checksum;
+    /* inclusive bounding box of the cells changed by the last generation,
+       with max_row < min_row when nothing changed */
+    int32_t changed_min_row;
+    int32_t changed_min_col;
+    int32_t changed_max_row;
+    int32_t changed_max_col;
+    /* time taken by the last call to tomato_step() */
+    double last_step_ms;
+} tomato_stats;
+
+int tomato_api_version(void);
+const char* tomato_last_error(void);
+
+/* A board of rows x cols cells, all in state 0, with no rule set. Returns
+   NULL if the size isn't positive or rows * cols is over INT_MAX. */
+tomato_board* tomato_board_create(int rows, int cols);
+void tomato_board_destroy(tomato_board* board);
+int tomato_board_rows(const tomato_board* board);
+int tomato_board_cols(const tomato_board* board);
+
+/* Selects a rule set by family and name, as listed by tomato-headless
+   --list. Cells in states the rule set doesn't have are set to 0, the rest
+   are kept. */
+tomato_status tomato_select_rule(
+    tomato_board* board, const char* family, const char* name
+);
+/* Selects a rule set of a family from its rule string, e.g. "Life" and
+   "23/3", or "LargerThanLife" and "R5,C0,M1,S34..58,B34..45,NM". Turmites
+   are in the family "Ants". Cells are kept as by tomato_select_rule(). */
+tomato_status tomato_select_rule_string(
+    tomato_board* board, const char* family, const char* rules
+);
+
+/* threads computing generations (1 by default) */
+tomato_status tomato_set_threads(tomato_board* board, int threads);
+
+/* symmetries of random boards */
+typedef enum tomato_symmetry {
+    TOMATO_SYMMETRY_NONE = 0,
+    /* left and right halves mirror each other */
+    TOMATO_SYMMETRY_COLUMNS,
+    /* top and bottom halves mirror each other */
+    TOMATO_SYMMETRY_ROWS,
+    TOMATO_SYMMETRY_BOTH,
+    /* the same when rotated by a half turn */
+    TOMATO_SYMMETRY_ROTATE2,
+    /* the same when rotated by a quarter turn (a half turn on boards that
+       aren't square) */
+    TOMATO_SYMMETRY_ROTATE4,
+} tomato_symmetry;
+
+/* Sets every cell to a random state of the rule set (a no-op for
+   turmites, which start on an empty board), every state being as likely.
+   The board only depends on the seed, not on the threads. */
+tomato_status tomato_randomize(tomato_board* board, uint64_t seed);
+/* Same, with 'weight_count' relative weights of the states (none for
+   every state being as likely) and, if 'density' is in [0, 1], that
+   fraction of the cells in a state other than 0. */
+tomato_status tomato_randomize_soup(
+    tomato_board* board, uint64_t seed, double density,
+    const double* weights, size_t weight_count, tomato_symmetry symmetry
+);
+tomato_status tomato_step(tomato_board* board, int generations);
+
+/* 'cells' holds rows * cols states, row by row. States the selected rule
+   set doesn't have can't be written. */
+tomato_status tomato_read_cells(
+    const tomato_board* board, uint8_t* cells, size_t count
+);
+tomato_status tomato_write_cells(
+    tomato_board* board, const uint8_t* cells, size_t count
+);
+tomato_status tomato_get_cell(
+    const tomato_board* board, int row, int col, uint8_t* state
+);
+tomato_status tomato_set_cell(
+    tomato_board* board, int row, int col, uint8_t state
+);
+
+tomato_status tomato_get_stats(
+    const tomato_board* board, tomato_stats* stats
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,79 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free triple buffer handing values from one writer thread to one
+// reader thread.
+//
+// The writer fills its private back slot and publishes it, which swaps it
+// with the middle slot. The reader takes the middle slot whenever a newer
+// one has been published, swapping it with its private front slot. Neither
+// side ever waits for the other: the writer can publish as often as it
+// likes (unread values are simply replaced), and the reader always sees the
+// newest published value.
+template<typename T>
+class TripleBuffer {
+    private:
+        // the middle slot is stored as its index in the low bits, with
+        // FRESH set when it holds a value the reader hasn't taken yet
+        static constexpr uint8_t INDEX_MASK = 3;
+        static constexpr uint8_t FRESH = 4;
+
+        std::array<T, 3> slots;
+        std::atomic<uint8_t> middle { 1 };
+
+        // owned by the writer
+        uint8_t back = 0;
+        uint8_t published = 1;
+        // owned by the reader
+        uint8_t front = 2;
+
+    public:
+        // writer side
+
+        T& write_slot() { return slots[back]; }
+        // The last published value. It is never written again until a later
+        // publish, so the writer can keep reading it (e.g. as the input of
+        // the next value) while the reader may be reading it too.
+        const T& last_published() const { return slots[published]; }
+        // Whether the reader hasn't taken the last published value yet. It
+        // may do so right after this returns true.
+        bool last_unread() const {
+            return (middle.load(std::memory_order_acquire) & FRESH) != 0;
+        }
+
+        // Makes the write slot visible to the reader and takes a new write
+        // slot. Returns true if the reader had taken the previously
+        // published value, false if that value was overwritten unread.
+        bool publish() {
+            published = back;
+            uint8_t old = middle.exchange(
+                back | FRESH, std::memory_order_acq_rel
+            );
+            back = old & INDEX_MASK;
+            return (old & FRESH) == 0;
+        }
+
+        // reader side
+
+        // Takes the newest published value if there is one the reader hasn't
+        // seen yet. Returns false (and keeps the current one) otherwise.
+        bool update() {
+            if ((middle.load(std::memory_order_relaxed) & FRESH) == 0) {
+                return false;
+            }
+            uint8_t old = middle.exchange(front, std::memory_order_acq_rel);
+            front = old & INDEX_MASK;
+            return true;
+        }
+
+        const T& read_slot() const { return slots[front]; }
+        // The reader may change the value it holds, as long as the writer
+        // doesn't read those parts from last_published().
+        T& read_slot() { return slots[front]; }
+};
+
+#endif